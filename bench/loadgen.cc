@@ -0,0 +1,376 @@
+// loadgen: replays the production access mix against a running vsrvd and
+// reports latency percentiles and throughput per commit.
+//
+// Pacing is open-loop: request start times are scheduled on a fixed grid
+// from the target rate, and latency is measured from the *scheduled* start,
+// so a slow server accumulates queueing delay in the numbers instead of
+// silently slowing the generator (no coordinated omission).  Workers are
+// pinned one per core, each with its own pool of keep-alive connections and
+// its own histogram; results merge at the end and print as JSON.
+//
+//   usage: loadgen [-H host] [-p port] [-c conns/worker] [-t workers]
+//                  [-r req/s] [-d seconds] [-w warmup_seconds]
+//                  [-P server_pid]
+//
+// Default mix mirrors the access logs: 90% index.html, 8% style.css,
+// 2% the CV PDF.
+//
+// With -P this doubles as the soak harness (make soak): the server's
+// resident set is sampled once a second after warmup, and the run fails if
+// steady state drifts -- the last quarter's mean RSS exceeding the first
+// quarter's by more than 5% and 8 MB.  A slab-and-freelist server should
+// plateau within the warmup; anything that keeps climbing for hours is a
+// leak or unbounded cache, whether or not ASan has a name for it.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+uint64_t now_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+struct Target {
+  const char* path;
+  int weight;  // percent
+};
+constexpr Target kMix[] = {
+    {"/index.html", 90},
+    {"/style.css", 8},
+    {"/Vladimir_Saraikin_CV.pdf", 2},
+};
+
+// Log-linear histogram: 1 us resolution up to 1 ms, then 64 buckets per
+// octave.  Good to ~1% error at the tail, fixed memory, mergeable.
+class Histogram {
+ public:
+  static constexpr int kBuckets = 2048;
+
+  void record(uint64_t us) {
+    samples_++;
+    buckets_[index_of(us)]++;
+  }
+  void merge(const Histogram& o) {
+    samples_ += o.samples_;
+    for (int i = 0; i < kBuckets; i++) buckets_[i] += o.buckets_[i];
+  }
+  uint64_t percentile(double p) const {
+    uint64_t rank = static_cast<uint64_t>(p * samples_);
+    uint64_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+      seen += buckets_[i];
+      if (seen >= rank && buckets_[i] > 0) return value_of(i);
+    }
+    return 0;
+  }
+  uint64_t samples() const { return samples_; }
+
+ private:
+  static int index_of(uint64_t us) {
+    if (us < 1024) return static_cast<int>(us);
+    int msb = 63 - __builtin_clzll(us);
+    int idx = 1024 + (msb - 10) * 64 +
+              static_cast<int>((us >> (msb - 6)) & 63);
+    return idx < kBuckets ? idx : kBuckets - 1;
+  }
+  static uint64_t value_of(int idx) {
+    if (idx < 1024) return idx;
+    int msb = (idx - 1024) / 64 + 10;
+    uint64_t frac = (idx - 1024) % 64;
+    return (1ull << msb) | (frac << (msb - 6));
+  }
+
+  uint64_t samples_ = 0;
+  uint64_t buckets_[kBuckets] = {};
+};
+
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 8080;
+  int conns = 16;
+  int workers = 1;
+  double rate = 10000;   // requests/sec across all workers
+  int duration = 10;     // measured seconds
+  int warmup = 2;        // seconds discarded while caches warm
+  int rss_pid = 0;       // server pid to watch for RSS drift; 0 = off
+};
+
+// Resident set of a process in KB via /proc/<pid>/statm, 0 if unreadable.
+uint64_t read_rss_kb(int pid) {
+  char path[64];
+  std::snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+  FILE* f = std::fopen(path, "r");
+  if (f == nullptr) return 0;
+  unsigned long long vsize = 0, resident = 0;
+  int n = std::fscanf(f, "%llu %llu", &vsize, &resident);
+  std::fclose(f);
+  if (n != 2) return 0;
+  return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+struct WorkerResult {
+  Histogram hist;
+  uint64_t sent = 0;
+  uint64_t done = 0;
+  uint64_t errors = 0;
+  uint64_t dropped = 0;  // scheduled arrivals with no idle connection
+};
+
+struct BenchConn {
+  int fd = -1;
+  bool busy = false;
+  uint64_t sched_ns = 0;   // scheduled start of the in-flight request
+  size_t want = 0;         // body bytes still expected
+  size_t got_hdr = 0;      // bytes of header buffered so far
+  char hbuf[1024];
+};
+
+int dial(const Config& cfg) {
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  struct sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(cfg.port);
+  inet_pton(AF_INET, cfg.host.c_str(), &addr.sin_addr);
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+              sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
+const char* pick_path(unsigned* seed) {
+  int r = rand_r(seed) % 100;
+  for (const Target& t : kMix) {
+    if (r < t.weight) return t.path;
+    r -= t.weight;
+  }
+  return kMix[0].path;
+}
+
+// Blocking read of one full response on fd; returns false on error.  The
+// server always sends Content-Length, so framing is trivial.
+bool read_response(BenchConn* c) {
+  // Header first.
+  for (;;) {
+    char* end = static_cast<char*>(
+        memmem(c->hbuf, c->got_hdr, "\r\n\r\n", 4));
+    if (end != nullptr) {
+      c->hbuf[c->got_hdr] = '\0';
+      const char* cl = std::strstr(c->hbuf, "Content-Length:");
+      if (cl == nullptr) return false;
+      size_t body = std::strtoull(cl + 15, nullptr, 10);
+      size_t have = c->got_hdr - (end + 4 - c->hbuf);
+      c->want = body > have ? body - have : 0;
+      break;
+    }
+    if (c->got_hdr >= sizeof(c->hbuf) - 1) return false;
+    ssize_t n = read(c->fd, c->hbuf + c->got_hdr,
+                     sizeof(c->hbuf) - 1 - c->got_hdr);
+    if (n <= 0) return false;
+    c->got_hdr += n;
+  }
+  char sink[16384];
+  while (c->want > 0) {
+    ssize_t n = read(c->fd, sink,
+                     c->want < sizeof(sink) ? c->want : sizeof(sink));
+    if (n <= 0) return false;
+    c->want -= n;
+  }
+  c->got_hdr = 0;
+  return true;
+}
+
+void worker(int index, const Config& cfg, WorkerResult* out) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index % sysconf(_SC_NPROCESSORS_ONLN), &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+  std::vector<BenchConn> conns(cfg.conns);
+  for (BenchConn& c : conns) c.fd = dial(cfg);
+
+  unsigned seed = 0x9e3779b9u * (index + 1);
+  const double per_worker_rate = cfg.rate / cfg.workers;
+  const uint64_t interval_ns =
+      static_cast<uint64_t>(1e9 / per_worker_rate);
+  const uint64_t start = now_ns();
+  const uint64_t warm_end = start + cfg.warmup * 1000000000ull;
+  const uint64_t end = warm_end + cfg.duration * 1000000000ull;
+
+  uint64_t next_sched = start;
+  int rr = 0;
+  while (now_ns() < end) {
+    uint64_t now = now_ns();
+    if (now < next_sched) {
+      struct timespec ts = {0, static_cast<long>(next_sched - now)};
+      nanosleep(&ts, nullptr);
+      now = next_sched;
+    }
+    uint64_t sched = next_sched;
+    next_sched += interval_ns;
+
+    // Round-robin to an idle connection.  With every connection stalled the
+    // arrival is dropped and counted -- open loop means we never wait.
+    BenchConn* c = nullptr;
+    for (int i = 0; i < cfg.conns; i++) {
+      BenchConn* cand = &conns[(rr + i) % cfg.conns];
+      if (cand->fd >= 0 && !cand->busy) {
+        c = cand;
+        rr = (rr + i + 1) % cfg.conns;
+        break;
+      }
+    }
+    if (c == nullptr) {
+      out->dropped++;
+      continue;
+    }
+
+    char req[256];
+    int len = std::snprintf(req, sizeof(req),
+                            "GET %s HTTP/1.1\r\n"
+                            "Host: %s\r\n"
+                            "Accept-Encoding: gzip, br\r\n"
+                            "\r\n",
+                            pick_path(&seed), cfg.host.c_str());
+    out->sent++;
+    if (write(c->fd, req, len) != len || !read_response(c)) {
+      out->errors++;
+      close(c->fd);
+      c->fd = dial(cfg);
+      continue;
+    }
+    uint64_t fin = now_ns();
+    if (fin > warm_end) {
+      out->hist.record((fin - sched) / 1000);
+      out->done++;
+    }
+  }
+  for (BenchConn& c : conns) {
+    if (c.fd >= 0) close(c.fd);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  for (int i = 1; i < argc; i++) {
+    auto next = [&](const char* flag) -> const char* {
+      if (i + 1 >= argc) {
+        std::fprintf(stderr, "loadgen: %s needs a value\n", flag);
+        std::exit(2);
+      }
+      return argv[++i];
+    };
+    if (!std::strcmp(argv[i], "-H")) cfg.host = next("-H");
+    else if (!std::strcmp(argv[i], "-p")) cfg.port = std::atoi(next("-p"));
+    else if (!std::strcmp(argv[i], "-c")) cfg.conns = std::atoi(next("-c"));
+    else if (!std::strcmp(argv[i], "-t")) cfg.workers = std::atoi(next("-t"));
+    else if (!std::strcmp(argv[i], "-r")) cfg.rate = std::atof(next("-r"));
+    else if (!std::strcmp(argv[i], "-d")) cfg.duration = std::atoi(next("-d"));
+    else if (!std::strcmp(argv[i], "-w")) cfg.warmup = std::atoi(next("-w"));
+    else if (!std::strcmp(argv[i], "-P")) cfg.rss_pid = std::atoi(next("-P"));
+    else {
+      std::fprintf(stderr,
+                   "usage: %s [-H host] [-p port] [-c conns] [-t workers] "
+                   "[-r req/s] [-d secs] [-w warmup] [-P server_pid]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+  if (cfg.rss_pid != 0 && read_rss_kb(cfg.rss_pid) == 0) {
+    std::fprintf(stderr, "loadgen: cannot read RSS of pid %d\n", cfg.rss_pid);
+    return 2;
+  }
+
+  std::vector<WorkerResult> results(cfg.workers);
+  std::vector<std::thread> threads;
+  uint64_t t0 = now_ns();
+  for (int i = 0; i < cfg.workers; i++) {
+    threads.emplace_back(worker, i, std::cref(cfg), &results[i]);
+  }
+
+  // RSS sampling rides on the main thread while workers run: one sample a
+  // second, warmup discarded so the cache-fill climb is not counted.
+  std::vector<uint64_t> rss;
+  if (cfg.rss_pid != 0) {
+    uint64_t warm_end = t0 + cfg.warmup * 1000000000ull;
+    uint64_t end = warm_end + cfg.duration * 1000000000ull;
+    while (now_ns() < end) {
+      sleep(1);
+      if (now_ns() > warm_end) rss.push_back(read_rss_kb(cfg.rss_pid));
+    }
+  }
+
+  for (auto& t : threads) t.join();
+  double elapsed = (now_ns() - t0) / 1e9 - cfg.warmup;
+
+  WorkerResult total;
+  for (const WorkerResult& r : results) {
+    total.hist.merge(r.hist);
+    total.sent += r.sent;
+    total.done += r.done;
+    total.errors += r.errors;
+    total.dropped += r.dropped;
+  }
+
+  // Steady-state drift: mean RSS of the last quarter of samples against
+  // the first quarter.  Dead samples (server gone) fail outright.
+  bool rss_fail = false;
+  uint64_t rss_first = 0, rss_last = 0;
+  if (!rss.empty()) {
+    size_t q = rss.size() >= 4 ? rss.size() / 4 : 1;
+    for (size_t i = 0; i < q; i++) rss_first += rss[i];
+    for (size_t i = rss.size() - q; i < rss.size(); i++) rss_last += rss[i];
+    rss_first /= q;
+    rss_last /= q;
+    uint64_t drift = rss_last > rss_first ? rss_last - rss_first : 0;
+    rss_fail = rss_first == 0 || rss_last == 0 ||
+               (drift * 20 > rss_first && drift > 8192);
+  }
+
+  // Machine-readable so CI can diff numbers commit to commit.
+  std::printf(
+      "{\"requests\": %llu, \"errors\": %llu, \"dropped\": %llu,\n"
+      " \"seconds\": %.2f, \"rps\": %.0f, \"rps_per_worker\": %.0f,\n"
+      " \"p50_us\": %llu, \"p99_us\": %llu, \"p999_us\": %llu",
+      static_cast<unsigned long long>(total.done),
+      static_cast<unsigned long long>(total.errors),
+      static_cast<unsigned long long>(total.dropped), elapsed,
+      total.done / elapsed, total.done / elapsed / cfg.workers,
+      static_cast<unsigned long long>(total.hist.percentile(0.50)),
+      static_cast<unsigned long long>(total.hist.percentile(0.99)),
+      static_cast<unsigned long long>(total.hist.percentile(0.999)));
+  if (!rss.empty()) {
+    std::printf(",\n \"rss_first_kb\": %llu, \"rss_last_kb\": %llu, "
+                "\"rss_ok\": %s",
+                static_cast<unsigned long long>(rss_first),
+                static_cast<unsigned long long>(rss_last),
+                rss_fail ? "false" : "true");
+  }
+  std::printf("}\n");
+  // >1% errors fails CI, and so does steady-state memory drift.
+  return (total.errors * 100 > total.sent || rss_fail) ? 1 : 0;
+}
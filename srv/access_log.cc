@@ -0,0 +1,78 @@
+#include "srv/access_log.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "srv/asset_store.h"
+
+namespace vsite {
+
+namespace {
+
+[[noreturn]] void die(const char* what) {
+  std::fprintf(stderr, "fatal: %s: %s\n", what, std::strerror(errno));
+  std::exit(1);
+}
+
+}  // namespace
+
+void AccessLog::open(const std::string& path, int shards,
+                     AssetStore& store) {
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+               0644);
+  if (fd_ < 0) die(path.c_str());
+
+  // Name table header, only when starting a fresh file; an appended-to log
+  // keeps its original table (the asset set only ever grows in a run).
+  if (lseek(fd_, 0, SEEK_END) == 0) {
+    std::string hdr(kLogMagic, 4);
+    uint32_t count = static_cast<uint32_t>(store.assets().size());
+    hdr.append(reinterpret_cast<const char*>(&count), 4);
+    for (const Asset& a : store.assets()) {
+      uint8_t len = static_cast<uint8_t>(a.url_path.size());
+      hdr.push_back(static_cast<char>(len));
+      hdr.append(a.url_path.data(), len);
+    }
+    if (write(fd_, hdr.data(), hdr.size()) !=
+        static_cast<ssize_t>(hdr.size())) {
+      die(path.c_str());
+    }
+  }
+
+  for (int i = 0; i < shards; i++) {
+    rings_.push_back(std::make_unique<LogRing>());
+  }
+
+  std::thread t([this] { writer_main(); });
+  t.detach();
+}
+
+void AccessLog::writer_main() {
+  // Drain cadence trades freshness for batch size; 50 ms keeps each write
+  // well under one ring of backlog at any sane request rate.
+  static LogRecord batch[4096];
+  for (;;) {
+    usleep(50 * 1000);
+    for (auto& ring : rings_) {
+      size_t n;
+      while ((n = ring->drain(batch, 4096)) > 0) {
+        const char* p = reinterpret_cast<const char*>(batch);
+        size_t left = n * sizeof(LogRecord);
+        while (left > 0) {
+          ssize_t w = write(fd_, p, left);
+          if (w <= 0) break;  // disk trouble: drop the batch, stay alive
+          p += w;
+          left -= w;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace vsite
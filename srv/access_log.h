@@ -0,0 +1,98 @@
+// Access logging off the hot path.
+//
+// The request path appends one fixed-size binary record to its shard's SPSC
+// ring -- a bounds check, a 32-byte copy and a release store, well under
+// 100 ns -- and never touches the disk or a lock.  A dedicated writer
+// thread drains every ring a few times a second and batches the records to
+// the log file.  When a ring fills (writer stalled on disk), records are
+// dropped and counted rather than ever blocking a serving core.
+//
+// The file starts with the asset name table so records can carry a 2-byte
+// asset index instead of a path; tools/logcat turns the binary stream back
+// into CLF or JSON.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vsite {
+
+class AssetStore;
+
+constexpr char kLogMagic[4] = {'V', 'L', 'G', '1'};
+
+struct LogRecord {
+  uint64_t ts_ns;       // request arrival, CLOCK_MONOTONIC
+  uint32_t peer_ip;     // IPv4, network order
+  uint32_t latency_us;  // arrival to last byte
+  uint32_t resp_bytes;  // wire bytes written
+  int16_t asset_idx;    // index into the name table, -1 for 404
+  uint16_t status;
+  uint8_t encoding;     // Encoding value sent
+  uint8_t is_head;
+  uint8_t pad[6] = {};
+};
+static_assert(sizeof(LogRecord) == 32);
+
+// Single-producer (one shard) / single-consumer (the writer thread) ring.
+// Power-of-two capacity; unsynchronized except for the two indices.
+class LogRing {
+ public:
+  static constexpr size_t kCapacity = 16384;  // 512 KB per shard
+
+  bool push(const LogRecord& r) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    if (head - tail >= kCapacity) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    slots_[head & (kCapacity - 1)] = r;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side: copies up to max records out, advances the tail.
+  size_t drain(LogRecord* out, size_t max) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    size_t n = 0;
+    while (tail + n < head && n < max) {
+      out[n] = slots_[(tail + n) & (kCapacity - 1)];
+      n++;
+    }
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  uint64_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  LogRecord slots_[kCapacity];
+  alignas(64) std::atomic<uint64_t> head_{0};
+  alignas(64) std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
+
+class AccessLog {
+ public:
+  // Opens (appending) the log file, writes the asset name table if the file
+  // is new, and starts the writer thread.  Fatal on failure, like the other
+  // startup paths.
+  void open(const std::string& path, int shards, AssetStore& store);
+
+  LogRing* ring(int shard) { return rings_[shard].get(); }
+
+ private:
+  void writer_main();
+
+  std::vector<std::unique_ptr<LogRing>> rings_;
+  int fd_ = -1;
+};
+
+}  // namespace vsite
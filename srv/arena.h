@@ -0,0 +1,73 @@
+// Bump-pointer arena for per-core state.
+//
+// Each event loop owns one; connection records and any other loop-local
+// structures come out of it.  Blocks are carved with a bump pointer, never
+// individually freed, and objects are recycled via caller-side free lists --
+// so after the first few seconds of traffic the serving path performs no
+// malloc at all and never touches another core's memory.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace vsite {
+
+class Arena {
+ public:
+  explicit Arena(size_t block_size = 256 * 1024)
+      : block_size_(block_size) {}
+
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  ~Arena() {
+    for (Block* b = head_; b != nullptr;) {
+      Block* next = b->next;
+      std::free(b);
+      b = next;
+    }
+  }
+
+  void* alloc(size_t n, size_t align = alignof(std::max_align_t)) {
+    size_t off = (used_ + align - 1) & ~(align - 1);
+    if (head_ == nullptr || off + n > block_size_) {
+      grow(n);
+      off = 0;
+    }
+    used_ = off + n;
+    return head_->data + off;
+  }
+
+  template <typename T, typename... Args>
+  T* create(Args&&... args) {
+    return new (alloc(sizeof(T), alignof(T))) T(static_cast<Args&&>(args)...);
+  }
+
+  size_t bytes_reserved() const { return reserved_; }
+
+ private:
+  struct Block {
+    Block* next;
+    alignas(std::max_align_t) char data[];
+  };
+
+  void grow(size_t min) {
+    size_t sz = min > block_size_ ? min : block_size_;
+    auto* b = static_cast<Block*>(std::malloc(sizeof(Block) + sz));
+    if (b == nullptr) std::abort();  // per-core arenas must not fail quietly
+    b->next = head_;
+    head_ = b;
+    used_ = 0;
+    if (sz > block_size_) block_size_ = sz;
+    reserved_ += sz;
+  }
+
+  size_t block_size_;
+  size_t used_ = 0;
+  size_t reserved_ = 0;
+  Block* head_ = nullptr;
+};
+
+}  // namespace vsite
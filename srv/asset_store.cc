@@ -0,0 +1,396 @@
+#include "srv/asset_store.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include "srv/pack_format.h"
+
+namespace vsite {
+
+namespace {
+
+[[noreturn]] void die(const char* what) {
+  std::fprintf(stderr, "fatal: %s: %s\n", what, std::strerror(errno));
+  std::exit(1);
+}
+
+uint64_t content_hash(const char* p, size_t n) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < n; i++) {
+    h ^= static_cast<uint8_t>(p[i]);
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+// Content-addressed mapping intern, shared across every store in the
+// process.  With several sites loaded, the tenth identical style.css maps
+// to the first one's pages instead of ten copies; memory grows with unique
+// bytes, not with the tenant count.  Weak entries expire with their last
+// asset, so a deploy that changes the bytes releases the old generation as
+// usual.  Only the loading thread (main at startup, loop 0 on fs events)
+// calls this, so no lock.
+std::map<uint64_t, std::vector<std::weak_ptr<const Mapping>>> g_mappings;
+
+MappingRef intern_mapping(MappingRef m) {
+  auto& cands = g_mappings[content_hash(m->data, m->size)];
+  for (auto it = cands.begin(); it != cands.end();) {
+    if (MappingRef prev = it->lock()) {
+      if (prev->size == m->size &&
+          std::memcmp(prev->data, m->data, m->size) == 0) {
+        return prev;  // m unmaps on return; prev's bytes are identical
+      }
+      ++it;
+    } else {
+      it = cands.erase(it);
+    }
+  }
+  cands.push_back(m);
+  return m;
+}
+
+// mmap a single file read-only.  Returns null on any failure so callers can
+// keep the previous generation (or, for optional variants, serve identity).
+MappingRef map_file(const std::string& full) {
+  int fd = open(full.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return nullptr;
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+
+  void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (p == MAP_FAILED) {
+    close(fd);
+    return nullptr;
+  }
+
+  auto m = std::make_shared<Mapping>();
+  m->fd = fd;
+  m->data = static_cast<const char*>(p);
+  m->size = static_cast<size_t>(st.st_size);
+  return intern_mapping(std::move(m));
+}
+
+const char* variant_ext(Encoding e) {
+  switch (e) {
+    case Encoding::kGzip:   return ".gz";
+    case Encoding::kBrotli: return ".br";
+    case Encoding::kZstd:   return ".zst";
+    case Encoding::kIdentity: break;
+  }
+  return "";
+}
+
+}  // namespace
+
+const char* encoding_name(Encoding e) {
+  switch (e) {
+    case Encoding::kGzip:   return "gzip";
+    case Encoding::kBrotli: return "br";
+    case Encoding::kZstd:   return "zstd";
+    case Encoding::kIdentity: break;
+  }
+  return "";
+}
+
+Mapping::~Mapping() {
+  if (!owns) return;  // a pack slice; the parent owns the bytes
+  if (data != nullptr) munmap(const_cast<char*>(data), size);
+  if (fd >= 0) close(fd);
+}
+
+const char* content_type_for(const std::string& name) {
+  size_t dot = name.rfind('.');
+  std::string ext = dot == std::string::npos ? "" : name.substr(dot);
+  if (ext == ".html") return "text/html; charset=utf-8";
+  if (ext == ".css") return "text/css; charset=utf-8";
+  if (ext == ".pdf") return "application/pdf";
+  if (ext == ".svg") return "image/svg+xml";
+  if (ext == ".png") return "image/png";
+  if (ext == ".jpg" || ext == ".jpeg") return "image/jpeg";
+  if (ext == ".webp") return "image/webp";
+  if (ext == ".avif") return "image/avif";
+  if (ext == ".ico") return "image/x-icon";
+  if (ext == ".xml") return "application/xml";
+  if (ext == ".txt") return "text/plain; charset=utf-8";
+  // Deploy images are served to edge daemons, which range-read only the
+  // entries whose content hash changed.
+  if (ext == ".pack") return "application/octet-stream";
+  return nullptr;  // not servable
+}
+
+bool AssetStore::servable(const std::string& name) {
+  if (name.empty() || name[0] == '.') return false;
+  // Precompressed siblings are variants of their base asset, not assets.
+  for (const char* ext : {".gz", ".br", ".zst"}) {
+    if (name.size() > std::strlen(ext) &&
+        name.compare(name.size() - std::strlen(ext), std::string::npos,
+                     ext) == 0) {
+      return false;
+    }
+  }
+  return content_type_for(name) != nullptr;
+}
+
+void AssetStore::load(const std::string& root) {
+  root_ = root;
+  // The vector must never reallocate: shards hold Asset pointers and the
+  // response cache indexes by position.  kMaxAssets bounds the site.
+  assets_.reserve(kMaxAssets);
+
+  DIR* d = opendir(root.c_str());
+  if (d == nullptr) die(root.c_str());
+  while (struct dirent* ent = readdir(d)) {
+    std::string name = ent->d_name;
+    if (!servable(name)) continue;
+    if (assets_.size() >= kMaxAssets) {
+      std::fprintf(stderr, "warn: asset limit reached, skipping %s\n",
+                   name.c_str());
+      continue;
+    }
+    assets_.emplace_back("/" + name, name, content_type_for(name));
+  }
+  closedir(d);
+  if (assets_.empty()) {
+    std::fprintf(stderr, "fatal: no servable assets in %s\n", root.c_str());
+    std::exit(1);
+  }
+  for (Asset& a : assets_) {
+    if (!remap(a)) die(a.file_path.c_str());
+  }
+  published_.store(assets_.size(), std::memory_order_release);
+
+  load_preload();
+
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ < 0) die("inotify_init1");
+  // Watch the directory, not the files: editors and rsync replace files via
+  // rename, which retires per-file watches but always fires on the parent.
+  if (inotify_add_watch(inotify_fd_, root_.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    die("inotify_add_watch");
+  }
+}
+
+// The build pipeline records which subresources each page still references
+// after inlining (dist/.preload, "page target" per line); those become the
+// page's 103 Early Hints.  Absent file means no hints, which is fine.
+void AssetStore::parse_preload(std::istream& in) {
+  preload_.clear();
+  std::string page, target;
+  while (in >> page >> target) preload_[page].push_back(target);
+}
+
+void AssetStore::load_preload() {
+  std::ifstream f(root_ + "/.preload");
+  parse_preload(f);
+}
+
+void AssetStore::load_pack(const std::string& pack_path) {
+  size_t slash = pack_path.rfind('/');
+  root_ = slash == std::string::npos ? "." : pack_path.substr(0, slash);
+  pack_name_ = slash == std::string::npos ? pack_path
+                                          : pack_path.substr(slash + 1);
+  assets_.reserve(kMaxAssets);
+
+  MappingRef pack = map_file(pack_path);
+  if (!pack || !apply_pack(pack)) {
+    errno = EINVAL;
+    die(pack_path.c_str());
+  }
+  pack_ = std::move(pack);
+  if (assets_.empty()) {
+    std::fprintf(stderr, "fatal: no servable assets in %s\n",
+                 pack_path.c_str());
+    std::exit(1);
+  }
+
+  inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify_fd_ < 0) die("inotify_init1");
+  if (inotify_add_watch(inotify_fd_, root_.c_str(),
+                        IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    die("inotify_add_watch");
+  }
+}
+
+// Parses a packed image and swaps every named asset to its slice.  Slices
+// carry a reference to the image mapping, so the previous generation stays
+// mapped exactly as long as something still serves from it.
+bool AssetStore::apply_pack(MappingRef pack) {
+  if (pack->size < sizeof(PackHeader)) return false;
+  PackHeader hdr;
+  std::memcpy(&hdr, pack->data, sizeof(hdr));
+  if (std::memcmp(hdr.magic, kPackMagic, 4) != 0) return false;
+  if (sizeof(PackHeader) + hdr.count * sizeof(PackEntry) > pack->size)
+    return false;
+
+  for (uint32_t i = 0; i < hdr.count; i++) {
+    PackEntry e;
+    std::memcpy(&e, pack->data + sizeof(PackHeader) + i * sizeof(e),
+                sizeof(e));
+    e.name[sizeof(e.name) - 1] = '\0';
+    std::string name = e.name;
+    if (e.offset + e.size > pack->size) return false;
+
+    if (e.encoding == kPackMeta) {
+      if (name == ".preload") {
+        std::istringstream ss(
+            std::string(pack->data + e.offset, e.size));
+        parse_preload(ss);
+      }
+      continue;
+    }
+    if (e.encoding >= kNumEncodings || content_type_for(name) == nullptr)
+      continue;
+
+    Asset* a = nullptr;
+    for (Asset& cand : assets_) {
+      if (cand.file_path == name) a = &cand;
+    }
+    if (a == nullptr) {
+      if (assets_.size() >= kMaxAssets) {
+        std::fprintf(stderr, "warn: asset limit reached, skipping %s\n",
+                     name.c_str());
+        continue;
+      }
+      assets_.emplace_back("/" + name, name, content_type_for(name));
+      a = &assets_.back();
+    }
+
+    auto m = std::make_shared<Mapping>();
+    m->fd = pack->fd;
+    m->data = pack->data + e.offset;
+    m->size = e.size;
+    m->owns = false;
+    m->parent = pack;
+    if (static_cast<Encoding>(e.encoding) == Encoding::kIdentity) {
+      install_identity(*a, std::move(m));
+    } else {
+      a->swap_in(static_cast<Encoding>(e.encoding), std::move(m));
+    }
+  }
+  // Publish any assets the pack introduced only now, with every mapping in
+  // place; shards racing this deploy keep seeing the old count until then.
+  published_.store(assets_.size(), std::memory_order_release);
+  return true;
+}
+
+Asset* AssetStore::lookup(std::string_view path) {
+  std::string_view key = (path == "/") ? std::string_view("/index.html")
+                                       : path;
+  // Bounded by the published count, not size(): entries past it are still
+  // being set up by the deploy thread and must stay invisible here.
+  size_t n = published_.load(std::memory_order_acquire);
+  for (size_t i = 0; i < n; i++) {
+    if (assets_[i].url_path == key) return &assets_[i];
+  }
+  return nullptr;
+}
+
+bool AssetStore::remap(Asset& a) {
+  MappingRef m = map_file(root_ + "/" + a.file_path);
+  if (!m) return false;
+  install_identity(a, std::move(m));
+  remap_variants(a);
+  return true;
+}
+
+void AssetStore::install_identity(Asset& a, MappingRef m) {
+  if (a.content_type == "application/pdf") {
+    auto idx = std::make_shared<PdfIndex>();
+    if (idx->build(m->data, m->size)) {
+      std::fprintf(stderr,
+                   "pdf index: %s: %zu objects, %slinearized, first page "
+                   "%zu/%zu bytes\n",
+                   a.file_path.c_str(), idx->object_count(),
+                   idx->linearized() ? "" : "not ",
+                   idx->first_page_extent(m->size), m->size);
+    }
+    a.set_pdf_index(std::move(idx));
+  }
+  a.swap_in(Encoding::kIdentity, std::move(m));
+}
+
+void AssetStore::remap_variants(Asset& a) {
+  // Precompressed siblings are optional: a missing or stale one simply means
+  // that encoding is not offered until the next deploy drops it in place.
+  for (Encoding e : {Encoding::kGzip, Encoding::kBrotli, Encoding::kZstd}) {
+    a.swap_in(e, map_file(root_ + "/" + a.file_path + variant_ext(e)));
+  }
+}
+
+void AssetStore::handle_fs_events() {
+  char buf[4096] __attribute__((aligned(alignof(struct inotify_event))));
+  for (;;) {
+    ssize_t n = read(inotify_fd_, buf, sizeof(buf));
+    if (n <= 0) return;  // EAGAIN: queue drained
+    for (char* p = buf; p < buf + n;) {
+      auto* ev = reinterpret_cast<struct inotify_event*>(p);
+      if (ev->len > 0) {
+        std::string name = ev->name;
+        if (!pack_name_.empty()) {
+          // Packed mode: the only file that matters is the image itself.
+          if (name == pack_name_) {
+            MappingRef pack = map_file(root_ + "/" + pack_name_);
+            if (pack && apply_pack(pack)) {
+              pack_ = std::move(pack);
+              std::fprintf(stderr, "deploy: swapped in new %s generation\n",
+                           pack_name_.c_str());
+            } else {
+              std::fprintf(stderr, "warn: bad pack %s, keeping old "
+                           "generation\n", name.c_str());
+            }
+          }
+          p += sizeof(struct inotify_event) + ev->len;
+          continue;
+        }
+        if (name == ".preload") load_preload();
+        bool known = false;
+        for (Asset& a : assets_) {
+          if (a.file_path == name || name.rfind(a.file_path, 0) == 0)
+            known = true;
+        }
+        if (!known && servable(name) && assets_.size() < kMaxAssets) {
+          // A deploy introduced a new file (e.g. a fresh hashed name).
+          // Reserved capacity keeps the storage stable, and the entry only
+          // becomes visible to lookup() once its mapping is in; a failed
+          // remap can therefore pop it with no reader holding a reference.
+          assets_.emplace_back("/" + name, name, content_type_for(name));
+          if (remap(assets_.back())) {
+            published_.store(assets_.size(), std::memory_order_release);
+          } else {
+            assets_.pop_back();
+          }
+        }
+        for (Asset& a : assets_) {
+          if (a.file_path == name) {
+            if (!remap(a)) {
+              std::fprintf(stderr, "warn: remap of %s failed, keeping old "
+                           "generation\n", a.file_path.c_str());
+            }
+          } else if (name.rfind(a.file_path, 0) == 0) {
+            // A precompressed sibling changed on its own.
+            remap_variants(a);
+          }
+        }
+      }
+      p += sizeof(struct inotify_event) + ev->len;
+    }
+  }
+}
+
+}  // namespace vsite
@@ -0,0 +1,151 @@
+// Asset store: the site's files (index.html, style.css, the CV PDF) mapped
+// into memory once at startup and kept current via inotify.
+//
+// Readers never take a lock.  Each asset's current mapping lives behind an
+// atomically swapped shared_ptr; a request grabs a snapshot and holds it for
+// the lifetime of the response, so a deploy that rewrites index.html can
+// remap underneath live connections without dropping or corrupting any of
+// them.  The old mapping is unmapped when the last in-flight response
+// releases its snapshot.
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <iosfwd>
+#include <string_view>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "srv/pdf_index.h"
+
+namespace vsite {
+
+// One immutable generation of a file's bytes.  Holds both the mapping (for
+// inspection and small writev sends) and the open fd (for sendfile, which is
+// the zero-copy path for large bodies like the PDF).
+struct Mapping {
+  int fd = -1;
+  const char* data = nullptr;
+  size_t size = 0;
+
+  // Slices into a packed deploy image do not own their bytes; parent pins
+  // the image's mapping until the last slice is released.
+  bool owns = true;
+  std::shared_ptr<const Mapping> parent;
+
+  ~Mapping();
+  Mapping() = default;
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+};
+
+using MappingRef = std::shared_ptr<const Mapping>;
+
+// Content codings a response body can be stored in.  Variants beyond
+// identity come from precompressed siblings (index.html.br etc.) emitted by
+// tools/precompress; the server picks one per request from Accept-Encoding.
+enum class Encoding : uint8_t { kIdentity = 0, kGzip, kBrotli, kZstd };
+constexpr int kNumEncodings = 4;
+
+// Wire name for the Content-Encoding header ("" for identity).
+const char* encoding_name(Encoding e);
+
+struct Asset {
+  Asset(std::string url, std::string file, std::string type)
+      : url_path(std::move(url)),
+        file_path(std::move(file)),
+        content_type(std::move(type)) {}
+
+  std::string url_path;      // e.g. "/index.html"
+  std::string file_path;     // path on disk, relative to the site root
+  std::string content_type;  // e.g. "text/html; charset=utf-8"
+
+  // Mapping for an encoding, or null if no precompressed sibling exists.
+  // Identity is always present once load() succeeds.
+  MappingRef current(Encoding e = Encoding::kIdentity) const {
+    return std::atomic_load(&mapping_[static_cast<int>(e)]);
+  }
+  void swap_in(Encoding e, MappingRef m) {
+    std::atomic_store(&mapping_[static_cast<int>(e)], std::move(m));
+  }
+
+  // For PDFs: xref/page-offset index rebuilt with each generation, null for
+  // other content types.  Lets ranged serving clamp open-ended reads to the
+  // linearized first-page extent.
+  std::shared_ptr<const PdfIndex> pdf_index() const {
+    return std::atomic_load(&pdf_index_);
+  }
+  void set_pdf_index(std::shared_ptr<const PdfIndex> idx) {
+    std::atomic_store(&pdf_index_, std::move(idx));
+  }
+
+ private:
+  MappingRef mapping_[kNumEncodings];
+  std::shared_ptr<const PdfIndex> pdf_index_;
+};
+
+class AssetStore {
+ public:
+  // Maps every registered file and sets up inotify watches on their parent
+  // directory.  Fatal on failure: a server with no assets has no job.
+  void load(const std::string& root);
+
+  // Serves from a packed deploy image instead of a directory: one mmap for
+  // the whole site, entries become zero-copy slices.  A rewritten pack file
+  // swaps every asset to the new generation atomically; redeploying the
+  // previous image is rollback.
+  void load_pack(const std::string& pack_path);
+
+  // Returns the asset for a request path, or nullptr for a miss.  "/" is an
+  // alias for "/index.html".  Takes a view so the request path is never
+  // copied out of the receive buffer.
+  Asset* lookup(std::string_view path);
+
+  // fd to poll for inotify events; feed readiness into handle_fs_events().
+  int inotify_fd() const { return inotify_fd_; }
+
+  // Drains the inotify queue and remaps any asset whose file changed.  A
+  // failed remap (e.g. mid-deploy partial file) keeps the old generation.
+  void handle_fs_events();
+
+  // Build-time preload targets for a page (from dist/.preload), or null.
+  // Only touched from the loop that owns inotify, so no synchronization.
+  const std::vector<std::string>* preload_targets(
+      const std::string& file_path) const {
+    auto it = preload_.find(file_path);
+    return it == preload_.end() ? nullptr : &it->second;
+  }
+
+  std::vector<Asset>& assets() { return assets_; }
+
+  // Upper bound on distinct assets; assets_ reserves this so it never
+  // reallocates under concurrent readers.
+  static constexpr size_t kMaxAssets = 64;
+
+ private:
+  bool remap(Asset& a);
+  void remap_variants(Asset& a);
+  void install_identity(Asset& a, MappingRef m);
+  bool apply_pack(MappingRef pack);
+  void load_preload();
+  void parse_preload(std::istream& in);
+  static bool servable(const std::string& name);
+
+  std::string root_;
+  std::string pack_name_;  // filename of the deploy image, "" for directories
+  MappingRef pack_;        // current packed generation
+  std::vector<Asset> assets_;
+  // How many leading entries of assets_ are visible to lookup().  Reserved
+  // capacity keeps the storage stable, but size() alone is not a safe
+  // publication point: a deploy thread growing the vector races shards
+  // iterating it.  The writer bumps this with release order only once the
+  // new asset's mapping is installed; readers load it with acquire.
+  std::atomic<size_t> published_{0};
+  std::map<std::string, std::vector<std::string>> preload_;
+  int inotify_fd_ = -1;
+};
+
+}  // namespace vsite
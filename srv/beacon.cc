@@ -0,0 +1,122 @@
+#include "srv/beacon.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "srv/asset_store.h"
+
+namespace vsite {
+
+namespace {
+
+[[noreturn]] void die(const char* what) {
+  std::fprintf(stderr, "fatal: %s: %s\n", what, std::strerror(errno));
+  std::exit(1);
+}
+
+struct Column {
+  const char* file;
+  size_t width;
+};
+constexpr Column kCols[] = {
+    {"ts.u64", 8}, {"ip.u32", 4}, {"page.i16", 2},
+    {"kind.c8", 8}, {"value.u32", 4},
+};
+
+}  // namespace
+
+void BeaconLog::open(const std::string& dir, int shards,
+                     AssetStore& store) {
+  if (mkdir(dir.c_str(), 0755) < 0 && errno != EEXIST) die(dir.c_str());
+
+  // Columns must stay row-aligned; a crash mid-flush can leave one longer
+  // than the rest, so truncate everything back to the shortest complete
+  // row count before appending.
+  size_t rows = ~size_t{0};
+  for (int i = 0; i < 5; i++) {
+    std::string path = dir + "/" + kCols[i].file;
+    fds_[i] = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC,
+                     0644);
+    if (fds_[i] < 0) die(path.c_str());
+    off_t size = lseek(fds_[i], 0, SEEK_END);
+    size_t r = static_cast<size_t>(size) / kCols[i].width;
+    if (r < rows) rows = r;
+  }
+  for (int i = 0; i < 5; i++) {
+    if (ftruncate(fds_[i], rows * kCols[i].width) < 0) {
+      die(kCols[i].file);
+    }
+  }
+
+  // Slot->path names, rewritten each start so the table tracks the asset
+  // set; page columns from older runs stay valid because slots are only
+  // ever appended within a run.
+  std::string names;
+  for (size_t i = 0; i < store.assets().size(); i++) {
+    names += std::to_string(i) + " " + store.assets()[i].url_path + "\n";
+  }
+  int nfd = ::open((dir + "/names").c_str(),
+                   O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (nfd < 0 ||
+      write(nfd, names.data(), names.size()) !=
+          static_cast<ssize_t>(names.size())) {
+    die("beacon names");
+  }
+  close(nfd);
+
+  for (int i = 0; i < shards; i++) {
+    rings_.push_back(std::make_unique<BeaconRing>());
+  }
+
+  std::thread t([this] { writer_main(); });
+  t.detach();
+}
+
+void BeaconLog::writer_main() {
+  // Transpose each drained batch into per-column staging buffers, then one
+  // append per column: five sequential writes per flush regardless of the
+  // event count, and readers scan each column without striding.
+  constexpr size_t kBatch = 4096;
+  static BeaconEvent batch[kBatch];
+  static uint64_t col_ts[kBatch];
+  static uint32_t col_ip[kBatch];
+  static int16_t col_page[kBatch];
+  static char col_kind[kBatch][8];
+  static uint32_t col_value[kBatch];
+  for (;;) {
+    usleep(50 * 1000);
+    for (auto& ring : rings_) {
+      size_t n;
+      while ((n = ring->drain(batch, kBatch)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+          col_ts[i] = batch[i].ts_ns;
+          col_ip[i] = batch[i].peer_ip;
+          col_page[i] = batch[i].page;
+          std::memcpy(col_kind[i], batch[i].kind, 8);
+          col_value[i] = batch[i].value;
+        }
+        const void* data[5] = {col_ts, col_ip, col_page, col_kind,
+                               col_value};
+        for (int c = 0; c < 5; c++) {
+          const char* p = static_cast<const char*>(data[c]);
+          size_t left = n * kCols[c].width;
+          while (left > 0) {
+            ssize_t w = write(fds_[c], p, left);
+            if (w <= 0) break;  // disk trouble: open() heals the tear
+            p += w;
+            left -= w;
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace vsite
@@ -0,0 +1,96 @@
+// First-party analytics beacons off the hot path.
+//
+// The serving core accepts tiny POSTs on /beacon and answers 204 from a
+// prebuilt buffer; recording an event is one fixed-size copy into the
+// shard's SPSC ring, the same sub-100 ns discipline as access logging.
+// A dedicated writer thread drains the rings a few times a second and
+// appends the batch in columnar form: one file per column, fixed-width
+// little-endian encodings (ts.u64, ip.u32, page.i16, kind.c8, value.u32).
+// Aggregation later is a sequential scan of just the columns a query
+// touches -- millions of events per second from cold cache -- instead of
+// re-parsing rows.  tools/beaconcat does the reading.
+//
+// Pages are recorded as asset slot indices with a names file written at
+// open, mirroring the access log's name table.  Event kinds are short
+// fixed-width tags ("view", "scroll"), so no dictionary is needed.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vsite {
+
+class AssetStore;
+
+struct BeaconEvent {
+  uint64_t ts_ns;     // request arrival, CLOCK_MONOTONIC
+  uint32_t peer_ip;   // IPv4, network order
+  uint32_t value;     // free-form metric (ms on page, scroll depth, ...)
+  int16_t page;       // asset slot of p=, -1 for unknown paths
+  char kind[8];       // e= tag, NUL padded
+  uint8_t pad[6] = {};
+};
+static_assert(sizeof(BeaconEvent) == 32);
+
+// Same single-producer / single-consumer shape as LogRing; events are
+// smaller than log records, so one ring is 512 KB per shard.
+class BeaconRing {
+ public:
+  static constexpr size_t kCapacity = 16384;
+
+  bool push(const BeaconEvent& e) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t tail = tail_.load(std::memory_order_acquire);
+    if (head - tail >= kCapacity) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    slots_[head & (kCapacity - 1)] = e;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t drain(BeaconEvent* out, size_t max) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    uint64_t head = head_.load(std::memory_order_acquire);
+    size_t n = 0;
+    while (tail + n < head && n < max) {
+      out[n] = slots_[(tail + n) & (kCapacity - 1)];
+      n++;
+    }
+    tail_.store(tail + n, std::memory_order_release);
+    return n;
+  }
+
+  uint64_t dropped() const {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  BeaconEvent slots_[kCapacity];
+  alignas(64) std::atomic<uint64_t> head_{0};
+  alignas(64) std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
+
+class BeaconLog {
+ public:
+  // Creates dir if needed, opens the column files appending, heals any
+  // torn tail from a crash, writes the slot->path names file and starts
+  // the writer thread.  Fatal on failure, like the other startup paths.
+  void open(const std::string& dir, int shards, AssetStore& store);
+
+  BeaconRing* ring(int shard) { return rings_[shard].get(); }
+
+ private:
+  void writer_main();
+
+  static constexpr int kColumns = 5;
+  std::vector<std::unique_ptr<BeaconRing>> rings_;
+  int fds_[kColumns] = {-1, -1, -1, -1, -1};
+};
+
+}  // namespace vsite
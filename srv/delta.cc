@@ -0,0 +1,129 @@
+#include "srv/delta.h"
+
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+namespace vsite {
+
+namespace {
+
+constexpr size_t kBlock = 32;
+constexpr char kOpCopy = 0x01;
+constexpr char kOpInsert = 0x02;
+
+uint64_t block_hash(const char* p) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < kBlock; i++) {
+    h ^= static_cast<uint8_t>(p[i]);
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+void put_u32(std::string* out, uint32_t v) {
+  out->append(reinterpret_cast<const char*>(&v), 4);
+}
+
+bool get_u32(std::string_view* in, uint32_t* v) {
+  if (in->size() < 4) return false;
+  std::memcpy(v, in->data(), 4);
+  in->remove_prefix(4);
+  return true;
+}
+
+void emit_insert(std::string* out, std::string_view lit) {
+  size_t pos = 0;
+  while (pos < lit.size()) {
+    size_t n = lit.size() - pos;
+    out->push_back(kOpInsert);
+    put_u32(out, static_cast<uint32_t>(n));
+    out->append(lit.data() + pos, n);
+    pos += n;
+  }
+}
+
+}  // namespace
+
+std::string delta_encode(std::string_view base, std::string_view target) {
+  std::string out;
+  if (base.size() < kBlock || target.size() < kBlock) {
+    emit_insert(&out, target);
+    return out;
+  }
+
+  // Base blocks at block boundaries; collisions chain in the vector.
+  std::unordered_map<uint64_t, std::vector<uint32_t>> blocks;
+  for (size_t off = 0; off + kBlock <= base.size(); off += kBlock) {
+    blocks[block_hash(base.data() + off)].push_back(
+        static_cast<uint32_t>(off));
+  }
+
+  size_t pos = 0;
+  size_t lit_start = 0;
+  while (pos + kBlock <= target.size()) {
+    auto it = blocks.find(block_hash(target.data() + pos));
+    bool matched = false;
+    if (it != blocks.end()) {
+      for (uint32_t boff : it->second) {
+        if (std::memcmp(base.data() + boff, target.data() + pos, kBlock) !=
+            0) {
+          continue;
+        }
+        // Extend the match both ways: backwards into pending literal,
+        // forwards as far as the bytes agree.
+        size_t b = boff, t = pos;
+        while (b > 0 && t > lit_start && base[b - 1] == target[t - 1]) {
+          b--;
+          t--;
+        }
+        size_t len = kBlock + (pos - t);
+        while (b + len < base.size() && t + len < target.size() &&
+               base[b + len] == target[t + len]) {
+          len++;
+        }
+        if (t > lit_start) {
+          emit_insert(&out, target.substr(lit_start, t - lit_start));
+        }
+        out.push_back(kOpCopy);
+        put_u32(&out, static_cast<uint32_t>(b));
+        put_u32(&out, static_cast<uint32_t>(len));
+        pos = t + len;
+        lit_start = pos;
+        matched = true;
+        break;
+      }
+    }
+    if (!matched) pos++;
+  }
+  if (lit_start < target.size()) {
+    emit_insert(&out, target.substr(lit_start));
+  }
+  return out;
+}
+
+bool delta_decode(std::string_view base, std::string_view delta,
+                  std::string* out) {
+  out->clear();
+  while (!delta.empty()) {
+    char op = delta.front();
+    delta.remove_prefix(1);
+    if (op == kOpCopy) {
+      uint32_t off, len;
+      if (!get_u32(&delta, &off) || !get_u32(&delta, &len)) return false;
+      if (off > base.size() || len > base.size() - off) return false;
+      out->append(base.data() + off, len);
+    } else if (op == kOpInsert) {
+      uint32_t len;
+      if (!get_u32(&delta, &len) || len > delta.size()) return false;
+      out->append(delta.data(), len);
+      delta.remove_prefix(len);
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace vsite
@@ -0,0 +1,32 @@
+// Byte-level delta encoding between two in-memory documents.
+//
+// Variant pages share most of their bytes with the canonical page; a
+// client (our edge daemon first) that already holds the base can fetch a
+// delta instead of the full body.  The format is deliberately dumb -- a
+// flat op stream, no compression of its own:
+//
+//   0x01 <u32 off> <u32 len>   copy len bytes from base at off
+//   0x02 <u32 len> <bytes>     insert literal bytes
+//
+// Encoding is rsync-shaped: base blocks are hashed into a table, the
+// target is scanned for matches which are then extended greedily.  One
+// pass, O(target bytes); results are cached by the response cache, so
+// encoding cost is paid once per (base, target) pair per generation.
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace vsite {
+
+// Delta that rebuilds target from base.  Never fails; worst case is one
+// big insert (caller decides whether that is worth sending).
+std::string delta_encode(std::string_view base, std::string_view target);
+
+// Applies a delta.  False on a malformed stream or out-of-range copy;
+// *out is then unspecified.
+bool delta_decode(std::string_view base, std::string_view delta,
+                  std::string* out);
+
+}  // namespace vsite
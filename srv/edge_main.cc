@@ -0,0 +1,293 @@
+// vedged: edge cache daemon.
+//
+// Serves the same packed deploy image as vsrvd -- same AssetStore, response
+// cache and event loops, so an edge box behaves byte-for-byte like origin --
+// and keeps it current by delta-syncing from the origin server.  Origin
+// exposes its pack as a plain ranged asset ("/site.pack"); the sync thread
+// fetches the entry index, compares per-entry content hashes against the
+// local image, and range-reads only the entries that changed.  A deploy
+// that touches index.html moves a few hundred bytes across the ocean, not
+// the PDF.
+//
+// The assembled image is written next to the local pack and renamed, which
+// drives the same inotify hot-swap path a local deploy uses.
+//
+//   usage: vedged -O origin_host:port [-p port] [-P local.pack]
+//                 [-u origin_path] [-i sync_secs] [-j shards]
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "srv/asset_store.h"
+#include "srv/event_loop.h"
+#include "srv/pack_format.h"
+#include "srv/response_cache.h"
+#include "srv/stats.h"
+
+namespace {
+
+struct Origin {
+  std::string host;
+  uint16_t port = 80;
+  std::string path = "/site.pack";
+};
+
+// One blocking ranged GET; sync runs off the serving threads, so simplicity
+// beats concurrency here.  Returns false on any transport or status error.
+bool fetch_range(const Origin& o, uint64_t first, uint64_t last,
+                 std::string* out) {
+  struct addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  struct addrinfo* res = nullptr;
+  char portbuf[8];
+  std::snprintf(portbuf, sizeof(portbuf), "%u", o.port);
+  if (getaddrinfo(o.host.c_str(), portbuf, &hints, &res) != 0) return false;
+  int fd = socket(res->ai_family, res->ai_socktype, 0);
+  if (fd < 0 || connect(fd, res->ai_addr, res->ai_addrlen) < 0) {
+    if (fd >= 0) close(fd);
+    freeaddrinfo(res);
+    return false;
+  }
+  freeaddrinfo(res);
+
+  char req[512];
+  int n = std::snprintf(req, sizeof(req),
+                        "GET %s HTTP/1.1\r\n"
+                        "Host: %s\r\n"
+                        "Range: bytes=%llu-%llu\r\n"
+                        "Connection: close\r\n"
+                        "\r\n",
+                        o.path.c_str(), o.host.c_str(),
+                        static_cast<unsigned long long>(first),
+                        static_cast<unsigned long long>(last));
+  if (write(fd, req, n) != n) {
+    close(fd);
+    return false;
+  }
+
+  std::string raw;
+  char buf[65536];
+  ssize_t r;
+  while ((r = read(fd, buf, sizeof(buf))) > 0) raw.append(buf, r);
+  close(fd);
+
+  size_t hdr_end = raw.find("\r\n\r\n");
+  if (hdr_end == std::string::npos) return false;
+  if (raw.compare(0, 12, "HTTP/1.1 206") != 0 &&
+      raw.compare(0, 12, "HTTP/1.1 200") != 0) {
+    return false;
+  }
+  *out = raw.substr(hdr_end + 4);
+  return out->size() == last - first + 1;
+}
+
+uint64_t fnv1a64(const char* data, size_t len) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < len; i++) {
+    h ^= static_cast<uint8_t>(data[i]);
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+std::string read_file(const std::string& path) {
+  std::ifstream f(path, std::ios::binary);
+  std::ostringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+// Parses a pack's entry index out of raw bytes.  Empty result on anything
+// malformed; the caller treats that as "nothing reusable".
+std::vector<vsite::PackEntry> parse_index(const std::string& img) {
+  std::vector<vsite::PackEntry> entries;
+  if (img.size() < sizeof(vsite::PackHeader)) return entries;
+  vsite::PackHeader hdr;
+  std::memcpy(&hdr, img.data(), sizeof(hdr));
+  if (std::memcmp(hdr.magic, vsite::kPackMagic, 4) != 0) return entries;
+  size_t need = sizeof(hdr) + hdr.count * sizeof(vsite::PackEntry);
+  if (need > img.size()) return entries;
+  entries.resize(hdr.count);
+  std::memcpy(entries.data(), img.data() + sizeof(hdr),
+              hdr.count * sizeof(vsite::PackEntry));
+  return entries;
+}
+
+// One sync round.  Returns true if a new generation was installed.
+bool sync_once(const Origin& o, const std::string& local_path) {
+  // Remote header first (its entry count sizes the index fetch).
+  std::string head;
+  if (!fetch_range(o, 0, sizeof(vsite::PackHeader) - 1, &head)) {
+    std::fprintf(stderr, "sync: origin unreachable or no pack\n");
+    return false;
+  }
+  vsite::PackHeader hdr;
+  std::memcpy(&hdr, head.data(), sizeof(hdr));
+  if (std::memcmp(hdr.magic, vsite::kPackMagic, 4) != 0 || hdr.count == 0) {
+    std::fprintf(stderr, "sync: origin pack has wrong magic\n");
+    return false;
+  }
+
+  uint64_t index_end =
+      sizeof(hdr) + hdr.count * sizeof(vsite::PackEntry) - 1;
+  std::string index_bytes;
+  if (!fetch_range(o, 0, index_end, &index_bytes)) return false;
+  std::vector<vsite::PackEntry> remote = parse_index(index_bytes);
+  if (remote.empty()) return false;
+
+  std::string local_img = read_file(local_path);
+  std::vector<vsite::PackEntry> local = parse_index(local_img);
+
+  // Already current?  Hash the remote index against the local one.
+  if (local.size() == remote.size() &&
+      std::memcmp(local.data(), remote.data(),
+                  local.size() * sizeof(vsite::PackEntry)) == 0) {
+    return false;
+  }
+
+  uint64_t total = 0;
+  for (const auto& e : remote) {
+    if (e.offset + e.size > total) total = e.offset + e.size;
+  }
+
+  std::string img(total, '\0');
+  std::memcpy(img.data(), index_bytes.data(), index_bytes.size());
+
+  uint64_t fetched = 0, reused = 0;
+  for (const auto& e : remote) {
+    const vsite::PackEntry* have = nullptr;
+    for (const auto& l : local) {
+      if (std::strncmp(l.name, e.name, sizeof(l.name)) == 0 &&
+          l.encoding == e.encoding && l.hash == e.hash &&
+          l.size == e.size && l.offset + l.size <= local_img.size()) {
+        have = &l;
+      }
+    }
+    if (have != nullptr &&
+        fnv1a64(local_img.data() + have->offset, have->size) == e.hash) {
+      std::memcpy(img.data() + e.offset, local_img.data() + have->offset,
+                  e.size);
+      reused += e.size;
+      continue;
+    }
+    std::string bytes;
+    if (!fetch_range(o, e.offset, e.offset + e.size - 1, &bytes) ||
+        fnv1a64(bytes.data(), bytes.size()) != e.hash) {
+      std::fprintf(stderr, "sync: fetch of %s failed, keeping current "
+                   "generation\n", e.name);
+      return false;
+    }
+    std::memcpy(img.data() + e.offset, bytes.data(), bytes.size());
+    fetched += e.size;
+  }
+
+  // Same rename discipline as tools/pack: the serving side must never map
+  // a half-written image.
+  std::string tmp = local_path + ".tmp";
+  std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+  if (!f.write(img.data(), img.size()).good()) {
+    std::fprintf(stderr, "sync: write failed: %s\n", tmp.c_str());
+    return false;
+  }
+  f.close();
+  if (std::rename(tmp.c_str(), local_path.c_str()) != 0) return false;
+
+  std::fprintf(stderr,
+               "sync: new generation, %llu bytes fetched, %llu reused\n",
+               static_cast<unsigned long long>(fetched),
+               static_cast<unsigned long long>(reused));
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Origin origin;
+  uint16_t port = 8080;
+  std::string local = "edge.pack";
+  int shards = 1;
+  int sync_secs = 30;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-O") == 0 && i + 1 < argc) {
+      std::string hp = argv[++i];
+      size_t colon = hp.rfind(':');
+      origin.host = hp.substr(0, colon);
+      if (colon != std::string::npos) {
+        origin.port = static_cast<uint16_t>(std::atoi(hp.c_str() + colon + 1));
+      }
+    } else if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+      port = static_cast<uint16_t>(std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+      local = argv[++i];
+    } else if (std::strcmp(argv[i], "-u") == 0 && i + 1 < argc) {
+      origin.path = argv[++i];
+    } else if (std::strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+      sync_secs = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      shards = std::atoi(argv[++i]);
+      if (shards <= 0) shards = std::thread::hardware_concurrency();
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s -O origin_host:port [-p port] [-P local.pack]"
+                   " [-u origin_path] [-i sync_secs] [-j shards]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+  if (origin.host.empty()) {
+    std::fprintf(stderr, "vedged: -O origin_host:port is required\n");
+    return 2;
+  }
+
+  // Cold start with no local image: the first sync is a full fetch (every
+  // entry misses), after which the server starts from the local pack.
+  if (read_file(local).empty() && !sync_once(origin, local)) {
+    std::fprintf(stderr, "vedged: initial sync from %s failed\n",
+                 origin.host.c_str());
+    return 1;
+  }
+
+  vsite::AssetStore store;
+  store.load_pack(local);
+  vsite::ResponseCache cache;
+  cache.build_all(store);
+  vsite::Stats stats(shards);
+
+  std::thread syncer([&] {
+    for (;;) {
+      sleep(sync_secs);
+      sync_once(origin, local);  // a swap lands via the inotify path
+    }
+  });
+  syncer.detach();
+
+  std::fprintf(stderr, "vedged: serving %s on port %u, syncing from "
+               "%s:%u%s every %ds\n",
+               local.c_str(), port, origin.host.c_str(), origin.port,
+               origin.path.c_str(), sync_secs);
+
+  std::vector<std::unique_ptr<vsite::EventLoop>> loops;
+  for (int i = 0; i < shards; i++) {
+    loops.push_back(std::make_unique<vsite::EventLoop>(
+        i, port, &store, &cache, nullptr, &stats.shard(i)));
+  }
+  std::vector<std::thread> threads;
+  for (int i = 1; i < shards; i++) {
+    threads.emplace_back([&loops, i] { loops[i]->run(); });
+  }
+  loops[0]->run();
+  return 0;
+}
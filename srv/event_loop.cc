@@ -0,0 +1,677 @@
+#include "srv/event_loop.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "srv/http_parser.h"
+#include "srv/site_set.h"
+
+namespace vsite {
+
+namespace {
+
+[[noreturn]] void die(const char* what) {
+  std::fprintf(stderr, "fatal: %s: %s\n", what, std::strerror(errno));
+  std::exit(1);
+}
+
+constexpr int kListenBacklog = 1024;
+
+// Consumes digits from the front of v.  Returns false if v does not start
+// with one; the parser's views are not NUL-terminated, so no strtoull.
+bool eat_u64(std::string_view* v, size_t* out) {
+  if (v->empty() || (*v)[0] < '0' || (*v)[0] > '9') return false;
+  size_t n = 0;
+  size_t i = 0;
+  while (i < v->size() && (*v)[i] >= '0' && (*v)[i] <= '9') {
+    n = n * 10 + ((*v)[i] - '0');
+    i++;
+  }
+  v->remove_prefix(i);
+  *out = n;
+  return true;
+}
+
+// Picks the best coding the client accepts from what the asset actually has
+// on disk.  Preference order mirrors compression ratio: br, zstd, gzip.
+Encoding negotiate_encoding(std::string_view accepted, const Asset* a,
+                            const ResponseCache& cache) {
+  if (accepted.empty()) return Encoding::kIdentity;
+  for (Encoding e :
+       {Encoding::kBrotli, Encoding::kZstd, Encoding::kGzip}) {
+    if (accepted.find(encoding_name(e)) != std::string_view::npos &&
+        cache.get(*a, e)) {
+      return e;
+    }
+  }
+  return Encoding::kIdentity;
+}
+
+// Serves a "Range: bytes=..." request against the identity mapping.  Only
+// single ranges are supported -- that is all PDF viewers send.  Open-ended
+// reads from offset 0 on a linearized PDF are clamped to the first-page
+// extent from the xref index, so a viewer gets page one in a single small
+// response and fetches the rest on demand.
+ResponseRef range_response(std::string_view range, const Asset* a) {
+  if (range.substr(0, 6) != "bytes=") return nullptr;
+  range.remove_prefix(6);
+
+  MappingRef m = a->current(Encoding::kIdentity);
+  if (!m) return nullptr;
+  size_t size = m->size;
+
+  size_t first = 0, last = size - 1;
+  if (!range.empty() && range[0] == '-') {
+    // Suffix form: last N bytes.
+    range.remove_prefix(1);
+    size_t n = 0;
+    if (!eat_u64(&range, &n) || n == 0) {
+      return build_range_unsatisfiable(size);
+    }
+    first = n >= size ? 0 : size - n;
+  } else {
+    if (!eat_u64(&range, &first)) return nullptr;
+    if (range.empty() || range[0] != '-') return nullptr;
+    range.remove_prefix(1);
+    if (first >= size) return build_range_unsatisfiable(size);
+    if (eat_u64(&range, &last)) {
+      if (last >= size) last = size - 1;
+      if (last < first) return build_range_unsatisfiable(size);
+    } else {
+      last = size - 1;
+      if (first == 0) {
+        if (auto idx = a->pdf_index(); idx && idx->linearized()) {
+          last = idx->first_page_extent(size) - 1;
+        }
+      }
+    }
+  }
+  return build_range_response(*a, *m, first, last);
+}
+
+// Fills an event from a beacon body ("p=/path&e=view&v=123").  One pass
+// over bytes already sitting in the receive buffer; the only copy is the
+// 8-byte kind tag.  Returns false on anything malformed, which drops the
+// event -- the client still gets its 204, sendBeacon cannot react anyway.
+bool parse_beacon(std::string_view body, AssetStore* store,
+                  BeaconEvent* ev) {
+  ev->page = -1;
+  bool have_kind = false;
+  while (!body.empty()) {
+    size_t amp = body.find('&');
+    std::string_view field = body.substr(0, amp);
+    body = amp == std::string_view::npos ? std::string_view()
+                                         : body.substr(amp + 1);
+    if (field.substr(0, 2) == "p=") {
+      Asset* a = store->lookup(field.substr(2));
+      if (a != nullptr) {
+        ev->page = static_cast<int16_t>(a - store->assets().data());
+      }
+    } else if (field.substr(0, 2) == "e=") {
+      std::string_view k = field.substr(2);
+      if (k.empty() || k.size() > sizeof(ev->kind)) return false;
+      std::memcpy(ev->kind, k.data(), k.size());
+      have_kind = true;
+    } else if (field.substr(0, 2) == "v=") {
+      std::string_view v = field.substr(2);
+      size_t n = 0;
+      if (!eat_u64(&v, &n) || !v.empty()) return false;
+      ev->value = n > UINT32_MAX ? UINT32_MAX
+                                 : static_cast<uint32_t>(n);
+    } else {
+      return false;
+    }
+  }
+  return have_kind;
+}
+
+}  // namespace
+
+int make_listener(uint16_t port) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) die("socket");
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  // Every shard binds its own listener; the kernel hashes incoming
+  // connections across them, which is our cross-core load balancing.
+  setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+  struct sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0)
+    die("bind");
+  if (listen(fd, kListenBacklog) < 0) die("listen");
+  return fd;
+}
+
+EventLoop::EventLoop(int index, uint16_t port, AssetStore* store,
+                     ResponseCache* cache, TlsContext* tls,
+                     ShardStats* stats, LogRing* log, int listen_fd,
+                     SearchIndex* search, SiteSet* sites,
+                     BeaconRing* beacon)
+    : index_(index), store_(store), cache_(cache), tls_(tls),
+      stats_(stats), log_(log), search_(search), sites_(sites),
+      beacon_(beacon) {
+  listen_fd_ = listen_fd >= 0 ? listen_fd : make_listener(port);
+  epfd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epfd_ < 0) die("epoll_create1");
+
+  struct epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.ptr = nullptr;  // listener sentinel
+  if (epoll_ctl(epfd_, EPOLL_CTL_ADD, listen_fd_, &ev) < 0) die("epoll_ctl");
+
+  if (index_ == 0) {
+    // One inotify watch per site, all serviced by this loop; the swapped
+    // generations are visible to every shard through the atomic loads.
+    if (sites_ != nullptr) {
+      for (size_t i = 0; i < sites_->size(); i++) {
+        Site& s = sites_->site(i);
+        fs_watches_.push_back({&s.store, &s.cache});
+      }
+    } else {
+      fs_watches_.push_back({store_, cache_});
+    }
+    for (const FsWatch& w : fs_watches_) {
+      struct epoll_event iev{};
+      iev.events = EPOLLIN;
+      iev.data.ptr = w.store;  // inotify sentinel
+      if (epoll_ctl(epfd_, EPOLL_CTL_ADD, w.store->inotify_fd(), &iev) < 0)
+        die("epoll_ctl inotify");
+    }
+  }
+}
+
+Conn* EventLoop::alloc_conn() {
+  if (free_conns_ != nullptr) {
+    Conn* c = free_conns_;
+    free_conns_ = c->next_free;
+    c->next_free = nullptr;
+    c->rlen = 0;
+    c->resp.reset();
+    c->hints.reset();
+    c->keep_alive = true;
+    return c;
+  }
+  return arena_.create<Conn>();
+}
+
+void EventLoop::recycle_conn(Conn* c) {
+  c->resp.reset();  // drop the pinned generation before the record idles
+  c->hints.reset();
+  c->next_free = free_conns_;
+  free_conns_ = c;
+}
+
+void EventLoop::close_conn(Conn* c) {
+  detach_timer(c);
+  if (c->ssl != nullptr) {
+    SSL_free(c->ssl);
+    c->ssl = nullptr;
+  }
+  epoll_ctl(epfd_, EPOLL_CTL_DEL, c->fd, nullptr);
+  close(c->fd);
+  c->fd = -1;
+  active_conns_--;
+  recycle_conn(c);
+}
+
+ssize_t EventLoop::conn_read(Conn* c, char* buf, size_t len) {
+  if (c->ssl == nullptr) return read(c->fd, buf, len);
+  int n = SSL_read(c->ssl, buf, static_cast<int>(len));
+  if (n > 0) return n;
+  int err = SSL_get_error(c->ssl, n);
+  if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+    set_events(c, err == SSL_ERROR_WANT_READ ? EPOLLIN : EPOLLOUT);
+    errno = EAGAIN;
+    return -1;
+  }
+  if (err == SSL_ERROR_ZERO_RETURN) return 0;
+  errno = ECONNRESET;
+  return -1;
+}
+
+ssize_t EventLoop::conn_write(Conn* c, const char* buf, size_t len) {
+  if (c->ssl == nullptr) return write(c->fd, buf, len);
+  int n = SSL_write(c->ssl, buf, static_cast<int>(len));
+  if (n > 0) return n;
+  int err = SSL_get_error(c->ssl, n);
+  if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+    set_events(c, err == SSL_ERROR_WANT_READ ? EPOLLIN : EPOLLOUT);
+    errno = EAGAIN;
+    return -1;
+  }
+  errno = ECONNRESET;
+  return -1;
+}
+
+void EventLoop::continue_handshake(Conn* c) {
+  int n = SSL_accept(c->ssl);
+  if (n == 1) {
+    c->handshaking = false;
+    tls_->count_handshake(SSL_session_reused(c->ssl) == 1);
+    set_events(c, EPOLLIN);
+    return;
+  }
+  int err = SSL_get_error(c->ssl, n);
+  if (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) {
+    set_events(c, err == SSL_ERROR_WANT_READ ? EPOLLIN : EPOLLOUT);
+    return;
+  }
+  close_conn(c);
+}
+
+void EventLoop::arm_timer(Conn* c) {
+  detach_timer(c);
+  c->deadline_tick = tick_ + kIdleTimeoutTicks;
+  Conn*& head = wheel_[c->deadline_tick & (kWheelSlots - 1)];
+  c->t_prev = nullptr;
+  c->t_next = head;
+  if (head != nullptr) head->t_prev = c;
+  head = c;
+}
+
+void EventLoop::detach_timer(Conn* c) {
+  if (c->t_prev != nullptr) {
+    c->t_prev->t_next = c->t_next;
+  } else if (wheel_[c->deadline_tick & (kWheelSlots - 1)] == c) {
+    wheel_[c->deadline_tick & (kWheelSlots - 1)] = c->t_next;
+  } else {
+    return;  // not linked
+  }
+  if (c->t_next != nullptr) c->t_next->t_prev = c->t_prev;
+  c->t_next = c->t_prev = nullptr;
+}
+
+void EventLoop::advance_wheel() {
+  uint64_t now = monotonic_ns();
+  while (now >= next_tick_ns_) {
+    tick_++;
+    next_tick_ns_ += 1000000000ull;
+    // Ticket-key rollover rides the same one-second counter: loop 0 rotates
+    // hourly, so resumption state ages out instead of the process serving
+    // its whole lifetime under the boot-time key.
+    if (index_ == 0 && tls_ != nullptr && tls_->enabled() &&
+        tick_ % kTicketRotateTicks == 0) {
+      tls_->rotate_ticket_key();
+    }
+    // Hashed wheel: the slot holds every deadline congruent mod the slot
+    // count, so entries further out stay linked and are skipped.
+    Conn* c = wheel_[tick_ & (kWheelSlots - 1)];
+    while (c != nullptr) {
+      Conn* next = c->t_next;
+      if (c->deadline_tick <= tick_) close_conn(c);
+      c = next;
+    }
+  }
+}
+
+int EventLoop::poll_timeout_ms() const {
+  uint64_t now = monotonic_ns();
+  if (now >= next_tick_ns_) return 0;
+  return static_cast<int>((next_tick_ns_ - now) / 1000000 + 1);
+}
+
+void EventLoop::set_events(Conn* c, uint32_t events) {
+  struct epoll_event ev{};
+  ev.events = events;
+  ev.data.ptr = c;
+  if (epoll_ctl(epfd_, EPOLL_CTL_MOD, c->fd, &ev) < 0) die("epoll_ctl");
+}
+
+void EventLoop::start_response(Conn* c, ResponseRef r, bool is_head) {
+  c->resp_off = 0;
+  c->resp_end = is_head ? r->header_len : r->wire.size();
+  c->is_head = is_head;
+  // Status digits sit at a fixed offset in every prebuilt status line.
+  const std::string& w = r->wire;
+  c->status = w.size() > 11
+                  ? (w[9] - '0') * 100 + (w[10] - '0') * 10 + (w[11] - '0')
+                  : 0;
+  c->resp = std::move(r);
+}
+
+bool EventLoop::flush_response(Conn* c) {
+  // The 103 block goes out first; it is a handful of bytes, so the common
+  // case is one extra write that completes immediately.
+  while (c->hints && c->hints_off < c->hints->wire.size()) {
+    ssize_t n = conn_write(c, c->hints->wire.data() + c->hints_off,
+                           c->hints->wire.size() - c->hints_off);
+    if (n < 0) {
+      if (errno == EAGAIN) {
+        if (c->ssl == nullptr) set_events(c, EPOLLOUT);
+        return true;
+      }
+      close_conn(c);
+      return false;
+    }
+    c->hints_off += n;
+    if (stats_ != nullptr && !c->ttfb_recorded) {
+      c->ttfb_recorded = true;
+      stats_->ttfb.record((monotonic_ns() - c->t_start) / 1000);
+    }
+  }
+  c->hints.reset();
+  while (c->resp_off < c->resp_end) {
+    ssize_t n = conn_write(c, c->resp->wire.data() + c->resp_off,
+                           c->resp_end - c->resp_off);
+    if (n < 0) {
+      if (errno == EAGAIN) {
+        if (c->ssl == nullptr) set_events(c, EPOLLOUT);
+        return true;
+      }
+      close_conn(c);
+      return false;
+    }
+    c->resp_off += n;
+    if (stats_ != nullptr && !c->ttfb_recorded && c->resp_off > 0) {
+      c->ttfb_recorded = true;
+      stats_->ttfb.record((monotonic_ns() - c->t_start) / 1000);
+    }
+  }
+  uint64_t now = monotonic_ns();
+  if (stats_ != nullptr) {
+    stats_->response.record((now - c->t_start) / 1000);
+    stats_->count_hit(c->asset_idx);
+  }
+  if (log_ != nullptr) {
+    LogRecord rec{};
+    rec.ts_ns = c->t_start;
+    rec.peer_ip = c->peer_ip;
+    rec.latency_us = static_cast<uint32_t>((now - c->t_start) / 1000);
+    rec.resp_bytes = static_cast<uint32_t>(c->resp_end);
+    rec.asset_idx = static_cast<int16_t>(c->asset_idx);
+    rec.status = c->status;
+    rec.encoding = c->enc_sent;
+    rec.is_head = c->is_head;
+    log_->push(rec);  // full ring drops and counts, never blocks
+  }
+  c->resp.reset();
+  if (!c->keep_alive) {
+    close_conn(c);
+    return false;
+  }
+  c->rlen = 0;
+  arm_timer(c);  // the keep-alive idle clock starts after the last byte
+  set_events(c, EPOLLIN);
+  return true;
+}
+
+void EventLoop::handle_readable(Conn* c) {
+  if (c->rlen == 0) {
+    // First bytes of a (possibly keep-alive) request: latency clocks start
+    // here so idle time between requests is not charged to us.
+    c->t_start = monotonic_ns();
+    c->ttfb_recorded = false;
+  }
+  arm_timer(c);  // any readable byte counts as activity
+  for (;;) {
+    ssize_t n = conn_read(c, c->rbuf + c->rlen, kRecvBufSize - 1 - c->rlen);
+    if (n < 0) {
+      if (errno == EAGAIN) return;
+      close_conn(c);
+      return;
+    }
+    if (n == 0) {
+      close_conn(c);
+      return;
+    }
+    c->rlen += n;
+    ParsedRequest req;
+    ParseStatus st = parse_http_request(c->rbuf, c->rlen, &req);
+    if (st == ParseStatus::kBad) {
+      close_conn(c);
+      return;
+    }
+    if (st == ParseStatus::kOk) {
+      bool is_head = req.method == "HEAD";
+      c->http11 = req.version != "HTTP/1.0";
+      c->keep_alive = c->http11 && !iequals(req.header("Connection"),
+                                            "close");
+      // Host routing: every site keeps the single-site shape, so past this
+      // point the request path is identical whether one site is loaded or
+      // ten.  Unknown hosts resolve to the fallback site.
+      AssetStore* store = store_;
+      ResponseCache* cache = cache_;
+      SearchIndex* search = search_;
+      if (sites_ != nullptr) {
+        Site& s = sites_->find(req.header("Host"));
+        store = &s.store;
+        cache = &s.cache;
+        search = s.search.loaded() ? &s.search : nullptr;
+      }
+      // Each request costs a token too, or a parked keep-alive connection
+      // would ride its accept-time admit forever.
+      if (!limiter_.admit(c->peer_ip, c->t_start)) {
+        if (stats_ != nullptr) {
+          stats_->rejected.fetch_add(1, std::memory_order_relaxed);
+        }
+        c->keep_alive = false;
+        c->enc_sent = 0;
+        c->asset_idx = -1;
+        start_response(c, cache->too_many(), is_head);
+        flush_response(c);
+        return;
+      }
+      // Beacon ingest: the only POST whose body we read.  The head parser
+      // leaves the body bytes in the receive buffer; they must fit there
+      // alongside the head, which bounds a beacon at a few KB.  Accepting
+      // is one ring push -- no disk, no lock, no allocation -- and the 204
+      // is a prebuilt buffer.
+      if (beacon_ != nullptr && req.method == "POST" &&
+          req.path == "/beacon") {
+        std::string_view cl = req.header("Content-Length");
+        size_t blen = 0;
+        if (!eat_u64(&cl, &blen) || !cl.empty() || blen == 0 ||
+            req.head_len + blen > kRecvBufSize - 1) {
+          close_conn(c);
+          return;
+        }
+        if (c->rlen < req.head_len + blen) continue;  // body in flight
+        BeaconEvent ev{};
+        ev.ts_ns = c->t_start;
+        ev.peer_ip = c->peer_ip;
+        if (parse_beacon({c->rbuf + req.head_len, blen}, store, &ev)) {
+          beacon_->push(ev);  // full ring drops and counts, never blocks
+        }
+        c->enc_sent = 0;
+        c->asset_idx = -1;  // beacons do not count as page hits
+        start_response(c, cache->no_content(), false);
+        flush_response(c);
+        return;
+      }
+      // Search runs against the mapped index, not the asset table; the
+      // response is built per query like Range responses are.
+      if (search != nullptr && (req.method == "GET" || is_head) &&
+          req.path.substr(0, 10) == "/search?q=") {
+        c->enc_sent = 0;
+        c->asset_idx = -1;
+        start_response(c, build_search_response(*search,
+                                                req.path.substr(10)),
+                       is_head);
+        flush_response(c);
+        return;
+      }
+      // Method set is fixed; anything else falls through as a 404.
+      Asset* a = (req.method == "GET" || is_head)
+                     ? store->lookup(req.path)
+                     : nullptr;
+      c->enc_sent = 0;
+      c->asset_idx =
+          a != nullptr
+              ? static_cast<int>(a - store->assets().data())
+              : -1;
+      if (a != nullptr) {
+        // Delta negotiation (our edge daemon): the client holds the asset
+        // named by Delta-Base and wants just the difference.  Falls
+        // through to a full response when no worthwhile delta exists.
+        if (req.header("A-IM").find("vsite-bdiff") !=
+            std::string_view::npos) {
+          if (ResponseRef d = cache->delta_response(
+                  *a, req.header("Delta-Base"))) {
+            start_response(c, std::move(d), is_head);
+            flush_response(c);
+            return;
+          }
+        }
+        std::string_view range = req.header("Range");
+        ResponseRef ranged;
+        if (!range.empty()) ranged = range_response(range, a);
+        if (ranged) {
+          start_response(c, std::move(ranged), is_head);
+        } else {
+          Encoding enc =
+              negotiate_encoding(req.header("Accept-Encoding"), a, *cache);
+          c->enc_sent = static_cast<uint8_t>(enc);
+          ResponseRef full = cache->get(*a, enc);
+          std::string_view inm = req.header("If-None-Match");
+          if (!full) {
+            // Asset published but its cache entry not built yet (a deploy
+            // just added the file, build_all runs after this event).  404
+            // until the next request rather than serving a null entry.
+            start_response(c, cache->not_found(), is_head);
+          } else if (!inm.empty() &&
+                     inm.find(full->etag) != std::string_view::npos) {
+            // Revalidation hit: no body, and no 103 either -- the client
+            // has the page and its subresources.
+            start_response(c, cache->not_modified(*a, enc), is_head);
+          } else {
+            if (c->http11) {
+              c->hints = cache->early_hints(*a);
+              c->hints_off = 0;
+            }
+            start_response(c, std::move(full), is_head);
+          }
+        }
+      } else {
+        start_response(c, cache->not_found(), is_head);
+      }
+      flush_response(c);
+      return;
+    }
+    if (c->rlen >= kRecvBufSize - 1) {
+      close_conn(c);  // request head larger than any browser sends us
+      return;
+    }
+  }
+}
+
+void EventLoop::accept_ready() {
+  for (;;) {
+    struct sockaddr_in peer{};
+    socklen_t plen = sizeof(peer);
+    int cfd = accept4(listen_fd_, reinterpret_cast<struct sockaddr*>(&peer),
+                      &plen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (cfd < 0) break;
+    // Admission control before anything is allocated: an over-limit
+    // source costs exactly one close().
+    if (!limiter_.admit(peer.sin_addr.s_addr, monotonic_ns())) {
+      close(cfd);
+      if (stats_ != nullptr) {
+        stats_->rejected.fetch_add(1, std::memory_order_relaxed);
+      }
+      continue;
+    }
+    int one = 1;
+    setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    Conn* c = alloc_conn();
+    c->fd = cfd;
+    c->peer_ip = peer.sin_addr.s_addr;
+    if (tls_ != nullptr && tls_->enabled()) {
+      c->ssl = tls_->new_session(cfd);
+      if (c->ssl == nullptr) {
+        close(cfd);
+        c->fd = -1;
+        recycle_conn(c);
+        continue;
+      }
+      c->handshaking = true;
+    }
+    if (stats_ != nullptr) {
+      stats_->connections.fetch_add(1, std::memory_order_relaxed);
+    }
+    arm_timer(c);
+    c->t_start = monotonic_ns();
+    struct epoll_event cev{};
+    cev.events = EPOLLIN;
+    cev.data.ptr = c;
+    if (epoll_ctl(epfd_, EPOLL_CTL_ADD, cfd, &cev) < 0) {
+      close(cfd);
+      c->fd = -1;
+      detach_timer(c);
+      recycle_conn(c);
+      continue;
+    }
+    active_conns_++;
+  }
+}
+
+void EventLoop::run() {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index_ % sysconf(_SC_NPROCESSORS_ONLN), &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+  next_tick_ns_ = monotonic_ns() + 1000000000ull;
+
+  struct epoll_event events[256];
+  for (;;) {
+    int n = epoll_wait(epfd_, events, 256, poll_timeout_ms());
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      die("epoll_wait");
+    }
+    for (int i = 0; i < n; i++) {
+      void* tag = events[i].data.ptr;
+      if (tag == nullptr) {
+        accept_ready();
+      } else if (const FsWatch* w = find_fs_watch(tag)) {
+        w->store->handle_fs_events();
+        // Deploys are rare and the asset set is tiny; rebuilding every
+        // entry is cheaper than tracking which file the event named.
+        w->cache->build_all(*w->store);
+      } else {
+        Conn* c = static_cast<Conn*>(tag);
+        if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+          close_conn(c);
+        } else if (c->handshaking) {
+          continue_handshake(c);
+        } else if (c->resp) {
+          flush_response(c);
+        } else {
+          handle_readable(c);
+        }
+      }
+    }
+    // After the batch, not before: a reaped record must not still be
+    // reachable through a stale events[i].data.ptr.
+    advance_wheel();
+
+    if (drain_.load(std::memory_order_acquire)) {
+      if (accepting_) {
+        // The listener fd now belongs to the successor; stop polling it but
+        // do not close it -- the successor holds its own reference.
+        epoll_ctl(epfd_, EPOLL_CTL_DEL, listen_fd_, nullptr);
+        accepting_ = false;
+      }
+      // Established connections finish on this process (their TLS and
+      // parser state cannot cross); the idle reaper bounds the wait.
+      if (active_conns_ == 0) return;
+    }
+  }
+}
+
+}  // namespace vsite
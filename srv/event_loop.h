@@ -0,0 +1,178 @@
+// Per-core event loop.
+//
+// Sharded serving model: each core runs one EventLoop pinned to that core,
+// with its own SO_REUSEPORT listener so the kernel spreads accepts, its own
+// epoll instance, and its own Arena-backed pool of connection records.
+// Nothing on the request path crosses cores -- the only shared state is the
+// read-only asset store and response cache, reached through atomic
+// shared_ptr loads.  Connections are recycled through a free list, so the
+// steady state allocates nothing.
+//
+// Idle keep-alive connections are bounded by a hashed timer wheel: every
+// record is linked into a wheel slot keyed by its deadline tick, activity
+// relinks it, and each one-second tick scans a single slot.  A million
+// parked viewers cost flat memory (the slab) and O(1) work per tick, with
+// no per-connection timer objects or ordered map churn.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "srv/access_log.h"
+#include "srv/arena.h"
+#include "srv/asset_store.h"
+#include "srv/beacon.h"
+#include "srv/rate_limiter.h"
+#include "srv/response_cache.h"
+#include "srv/search_index.h"
+#include "srv/stats.h"
+#include "srv/tls.h"
+
+namespace vsite {
+
+class SiteSet;
+
+constexpr size_t kRecvBufSize = 4096;
+
+// Per-connection state.  Pool-allocated from the loop's arena; next_free
+// chains recycled records.
+struct Conn {
+  int fd = -1;
+  char rbuf[kRecvBufSize];
+  size_t rlen = 0;
+
+  ResponseRef resp;       // wire bytes being streamed, or null when reading
+  size_t resp_off = 0;
+  size_t resp_end = 0;    // header_len for HEAD, wire.size() otherwise
+  ResponseRef hints;      // 103 interim block, drained before resp
+  size_t hints_off = 0;
+  bool keep_alive = true;
+  bool http11 = true;     // interim responses are 1.1-only
+
+  SSL* ssl = nullptr;     // non-null on TLS listeners
+  bool handshaking = false;
+
+  uint64_t t_start = 0;   // request arrival, for latency histograms
+  int asset_idx = -1;     // which asset this response hits, -1 for 404
+  bool ttfb_recorded = false;
+  uint32_t peer_ip = 0;   // IPv4, network order, for access logging
+  uint16_t status = 0;    // from the response status line
+  uint8_t enc_sent = 0;   // Encoding value of the served variant
+  bool is_head = false;
+
+  // Timer wheel linkage (intrusive, so idle connections allocate nothing).
+  Conn* t_next = nullptr;
+  Conn* t_prev = nullptr;
+  uint32_t deadline_tick = 0;
+
+  Conn* next_free = nullptr;
+};
+
+// Idle connections are reaped after this long without a readable byte.
+constexpr uint32_t kIdleTimeoutTicks = 60;  // one tick per second
+
+// TLS ticket keys rotate on this cadence (loop 0 only); tickets issued
+// under the previous key keep resuming for one more generation.
+constexpr uint32_t kTicketRotateTicks = 3600;
+
+class EventLoop {
+ public:
+  // index selects the CPU to pin to; index 0 additionally owns the inotify
+  // watch (one loop remapping is enough, the swap is visible to all).
+  // tls may be null for a plaintext listener.  A listen_fd >= 0 is adopted
+  // instead of binding a new socket -- that is how a successor process
+  // inherits a predecessor's listeners on binary upgrade.  With a non-null
+  // sites, requests route to the site matching their Host header (store,
+  // cache and search then name the fallback site's shape).  A non-null
+  // beacon enables POST /beacon ingest into that ring.
+  EventLoop(int index, uint16_t port, AssetStore* store,
+            ResponseCache* cache, TlsContext* tls = nullptr,
+            ShardStats* stats = nullptr, LogRing* log = nullptr,
+            int listen_fd = -1, SearchIndex* search = nullptr,
+            SiteSet* sites = nullptr, BeaconRing* beacon = nullptr);
+
+  // Runs until begin_drain() plus the last connection closing; without a
+  // drain request, forever.  Call from the thread that should own this shard.
+  void run();
+
+  // Per-source admission control; call before run().  The limiter is
+  // loop-local, so each source effectively gets per_sec per shard it
+  // hashes onto -- with kernel REUSEPORT hashing that is per_sec total.
+  void set_rate_limit(uint32_t per_sec) { limiter_.configure(per_sec); }
+
+  // Stops accepting and lets run() return once every connection has closed.
+  // Called from the handoff thread after the listeners move to a successor;
+  // the loop notices within one wheel tick.  In-flight and keep-alive
+  // connections drain naturally, bounded by the idle reaper.
+  void begin_drain() { drain_.store(true, std::memory_order_release); }
+
+ private:
+  Conn* alloc_conn();
+  void recycle_conn(Conn* c);
+  void close_conn(Conn* c);
+  void set_events(Conn* c, uint32_t events);
+  void accept_ready();
+  void continue_handshake(Conn* c);
+  void handle_readable(Conn* c);
+  bool flush_response(Conn* c);
+  void start_response(Conn* c, ResponseRef r, bool is_head);
+  // read/write through the TLS session when present; -1/EAGAIN semantics
+  // either way, with the wanted poll direction applied as a side effect.
+  ssize_t conn_read(Conn* c, char* buf, size_t len);
+  ssize_t conn_write(Conn* c, const char* buf, size_t len);
+
+  // Hashed timer wheel: arm_timer (re)links a record into the slot for
+  // now + kIdleTimeoutTicks; advance_wheel expires one slot per tick.
+  void arm_timer(Conn* c);
+  void detach_timer(Conn* c);
+  void advance_wheel();
+  int poll_timeout_ms() const;
+
+  int index_;
+  int epfd_ = -1;
+  int listen_fd_ = -1;
+  AssetStore* store_;
+  ResponseCache* cache_;
+  TlsContext* tls_;
+  ShardStats* stats_;
+  LogRing* log_;
+  SearchIndex* search_;
+  SiteSet* sites_;
+  BeaconRing* beacon_;
+
+  // Inotify watches this loop polls (loop 0 only, one per site).  Tagged
+  // with the store pointer in epoll, so event dispatch can tell a watch
+  // from a connection; the scan is over at most a handful of sites.
+  struct FsWatch {
+    AssetStore* store;
+    ResponseCache* cache;
+  };
+  std::vector<FsWatch> fs_watches_;
+  const FsWatch* find_fs_watch(void* tag) const {
+    for (const FsWatch& w : fs_watches_) {
+      if (tag == w.store) return &w;
+    }
+    return nullptr;
+  }
+  RateLimiter limiter_;
+  Arena arena_;
+  Conn* free_conns_ = nullptr;
+
+  static constexpr uint32_t kWheelSlots = 128;  // power of two > timeout
+  Conn* wheel_[kWheelSlots] = {};
+  uint32_t tick_ = 0;
+  uint64_t next_tick_ns_ = 0;
+
+  std::atomic<bool> drain_{false};
+  bool accepting_ = true;
+  int active_conns_ = 0;
+};
+
+// Bound SO_REUSEPORT listener for the given port (fatal on failure).  Owned
+// by an EventLoop normally; created up front in main when the fds need to
+// outlive the loops for handoff.
+int make_listener(uint16_t port);
+
+}  // namespace vsite
@@ -0,0 +1,115 @@
+#include "srv/handoff.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace vsite {
+
+namespace {
+
+[[noreturn]] void die(const char* what) {
+  std::fprintf(stderr, "fatal: %s: %s\n", what, std::strerror(errno));
+  std::exit(1);
+}
+
+// More shards than any machine this serves from; bounds the cmsg buffer.
+constexpr uint32_t kMaxFds = 64;
+
+void fill_addr(const std::string& path, struct sockaddr_un* addr) {
+  std::memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr->sun_path)) {
+    errno = ENAMETOOLONG;
+    die("handoff socket path");
+  }
+  std::memcpy(addr->sun_path, path.c_str(), path.size());
+}
+
+}  // namespace
+
+std::vector<int> handoff_receive(const std::string& path) {
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) die("socket");
+  struct sockaddr_un addr;
+  fill_addr(path, &addr);
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr),
+              sizeof(addr)) < 0) {
+    close(fd);  // nobody listening: fresh start, not an error
+    return {};
+  }
+
+  // One message: a count in the data bytes, the fds in SCM_RIGHTS.
+  uint32_t count = 0;
+  char cbuf[CMSG_SPACE(sizeof(int) * kMaxFds)];
+  struct iovec iov{&count, sizeof(count)};
+  struct msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cbuf;
+  msg.msg_controllen = sizeof(cbuf);
+  ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+  close(fd);
+  if (n != static_cast<ssize_t>(sizeof(count)) || count == 0 ||
+      count > kMaxFds) {
+    die("handoff recvmsg");
+  }
+
+  std::vector<int> fds;
+  for (struct cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr;
+       c = CMSG_NXTHDR(&msg, c)) {
+    if (c->cmsg_level != SOL_SOCKET || c->cmsg_type != SCM_RIGHTS) continue;
+    size_t nfds = (c->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    fds.resize(nfds);
+    std::memcpy(fds.data(), CMSG_DATA(c), nfds * sizeof(int));
+  }
+  if (fds.size() != count) die("handoff fd count");
+  return fds;
+}
+
+void handoff_serve(const std::string& path, const std::vector<int>& fds) {
+  int sfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (sfd < 0) die("socket");
+  struct sockaddr_un addr;
+  fill_addr(path, &addr);
+  // Unlink-before-bind, never after: the predecessor's socket file (or a
+  // crashed one's) is stale the moment we own the listeners, and unlinking
+  // on the way out would race the next generation's bind.
+  unlink(path.c_str());
+  if (bind(sfd, reinterpret_cast<struct sockaddr*>(&addr),
+           sizeof(addr)) < 0) {
+    die("bind handoff");
+  }
+  if (listen(sfd, 1) < 0) die("listen handoff");
+
+  int peer;
+  do {
+    peer = accept(sfd, nullptr, nullptr);
+  } while (peer < 0 && errno == EINTR);
+  if (peer < 0) die("accept handoff");
+
+  uint32_t count = static_cast<uint32_t>(fds.size());
+  if (count > kMaxFds) die("handoff fd count");
+  char cbuf[CMSG_SPACE(sizeof(int) * kMaxFds)] = {};
+  struct iovec iov{&count, sizeof(count)};
+  struct msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = cbuf;
+  msg.msg_controllen = CMSG_SPACE(count * sizeof(int));
+  struct cmsghdr* c = CMSG_FIRSTHDR(&msg);
+  c->cmsg_level = SOL_SOCKET;
+  c->cmsg_type = SCM_RIGHTS;
+  c->cmsg_len = CMSG_LEN(count * sizeof(int));
+  std::memcpy(CMSG_DATA(c), fds.data(), count * sizeof(int));
+  if (sendmsg(peer, &msg, 0) < 0) die("sendmsg handoff");
+  close(peer);
+  close(sfd);
+}
+
+}  // namespace vsite
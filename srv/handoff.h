@@ -0,0 +1,31 @@
+// Listener handoff for zero-drop binary upgrades.
+//
+// A running server owns one SO_REUSEPORT listener per shard.  On upgrade,
+// the successor connects to the predecessor's handoff socket and receives
+// those exact fds over SCM_RIGHTS -- accept queues and all -- so no SYN is
+// ever lost.  The predecessor then stops accepting and drains: keep-alive
+// connections live out their natural lives (the idle reaper bounds the
+// tail) and the process exits when the last one closes.
+//
+// The successor builds its store and response cache before asking for the
+// fds, so the instant it owns them every response is already prebuilt --
+// that is the warm start.  There is nothing else worth serializing: the
+// cache is derived state, rebuilt from the mmapped assets in microseconds,
+// and shipping it as bytes would only add a versioned format to mismatch.
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace vsite {
+
+// Connects to a predecessor's handoff socket and receives its listener
+// fds.  Empty result when no predecessor is listening (fresh start).
+std::vector<int> handoff_receive(const std::string& path);
+
+// Binds the handoff socket and blocks until a successor connects, then
+// sends it the fds and returns (at which point the caller should drain).
+// Fatal if the socket cannot be bound.
+void handoff_serve(const std::string& path, const std::vector<int>& fds);
+
+}  // namespace vsite
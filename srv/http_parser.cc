@@ -0,0 +1,109 @@
+#include "srv/http_parser.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace vsite {
+
+namespace {
+
+constexpr uint64_t kOnes = 0x0101010101010101ull;
+constexpr uint64_t kHigh = 0x8080808080808080ull;
+
+inline uint64_t load64(const char* p) {
+  uint64_t v;
+  std::memcpy(&v, p, 8);
+  return v;
+}
+
+// Nonzero iff any lane of x equals b (the has-zero-byte trick applied to
+// x XOR broadcast(b)).
+inline uint64_t lanes_eq(uint64_t x, char b) {
+  uint64_t d = x ^ (kOnes * static_cast<uint8_t>(b));
+  return (d - kOnes) & ~d & kHigh;
+}
+
+// First occurrence of c in [p, end), or end.  Eight bytes per step.
+const char* find_byte(const char* p, const char* end, char c) {
+  while (end - p >= 8) {
+    uint64_t hit = lanes_eq(load64(p), c);
+    if (hit != 0) return p + (__builtin_ctzll(hit) >> 3);
+    p += 8;
+  }
+  while (p < end && *p != c) p++;
+  return p;
+}
+
+inline char lower(char c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<char>(c | 0x20) : c;
+}
+
+}  // namespace
+
+bool iequals(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (lower(a[i]) != lower(b[i])) return false;
+  }
+  return true;
+}
+
+std::string_view ParsedRequest::header(std::string_view name) const {
+  for (int i = 0; i < num_headers; i++) {
+    if (iequals(headers[i].name, name)) return headers[i].value;
+  }
+  return {};
+}
+
+ParseStatus parse_http_request(const char* buf, size_t len,
+                               ParsedRequest* out) {
+  const char* p = buf;
+  const char* end = buf + len;
+
+  // Request line: METHOD SP PATH SP VERSION CRLF.
+  const char* sp = find_byte(p, end, ' ');
+  if (sp == end) return len > 32 ? ParseStatus::kBad : ParseStatus::kIncomplete;
+  out->method = {p, static_cast<size_t>(sp - p)};
+  p = sp + 1;
+
+  sp = find_byte(p, end, ' ');
+  if (sp == end) return ParseStatus::kIncomplete;
+  out->path = {p, static_cast<size_t>(sp - p)};
+  p = sp + 1;
+
+  const char* cr = find_byte(p, end, '\r');
+  if (cr == end || cr + 1 == end) return ParseStatus::kIncomplete;
+  if (cr[1] != '\n') return ParseStatus::kBad;
+  out->version = {p, static_cast<size_t>(cr - p)};
+  p = cr + 2;
+
+  // Header fields until the empty line.
+  out->num_headers = 0;
+  for (;;) {
+    if (end - p < 2) return ParseStatus::kIncomplete;
+    if (p[0] == '\r' && p[1] == '\n') {
+      out->head_len = static_cast<size_t>(p + 2 - buf);
+      return ParseStatus::kOk;
+    }
+    cr = find_byte(p, end, '\r');
+    if (cr == end || cr + 1 == end) return ParseStatus::kIncomplete;
+    if (cr[1] != '\n') return ParseStatus::kBad;
+
+    const char* colon = find_byte(p, cr, ':');
+    if (colon == cr) return ParseStatus::kBad;
+    const char* v = colon + 1;
+    while (v < cr && (*v == ' ' || *v == '\t')) v++;
+    // Headers beyond the table are skipped, not failed: a browser sending
+    // 40 headers still only needs the handful we look up.
+    if (out->num_headers < ParsedRequest::kMaxHeaders) {
+      out->headers[out->num_headers].name = {
+          p, static_cast<size_t>(colon - p)};
+      out->headers[out->num_headers].value = {
+          v, static_cast<size_t>(cr - v)};
+      out->num_headers++;
+    }
+    p = cr + 2;
+  }
+}
+
+}  // namespace vsite
@@ -0,0 +1,51 @@
+// Purpose-built HTTP/1.1 request-head parser.
+//
+// The responses here are prebuilt buffers, so request parsing is the top
+// userspace cost; this parser is built to disappear from that profile.
+// Delimiters are found with SWAR scans (eight bytes per step, the same
+// broadcast-XOR trick the HTML minifier uses), every captured token is a
+// string_view into the connection's receive buffer -- no copies, no
+// allocation, no lowercased shadow buffers -- and header-name matching is
+// case-insensitive on the fly.
+//
+// Only the request head is parsed; this server reads no bodies.
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace vsite {
+
+enum class ParseStatus {
+  kOk,          // complete head parsed
+  kIncomplete,  // need more bytes
+  kBad,         // malformed; close the connection
+};
+
+struct ParsedRequest {
+  static constexpr int kMaxHeaders = 32;
+
+  std::string_view method;
+  std::string_view path;
+  std::string_view version;  // e.g. "HTTP/1.1"
+  struct Header {
+    std::string_view name;
+    std::string_view value;
+  };
+  Header headers[kMaxHeaders];
+  int num_headers = 0;
+  size_t head_len = 0;  // bytes through the terminating CRLFCRLF
+
+  // Value for a header name (case-insensitive), or empty if absent.
+  std::string_view header(std::string_view name) const;
+};
+
+// ASCII case-insensitive equality without copying or tolower tables.
+bool iequals(std::string_view a, std::string_view b);
+
+// Parses [buf, buf+len).  On kOk every view in *out points into buf and
+// stays valid exactly as long as those bytes do.
+ParseStatus parse_http_request(const char* buf, size_t len,
+                               ParsedRequest* out);
+
+}  // namespace vsite
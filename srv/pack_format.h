@@ -0,0 +1,35 @@
+// Packed deploy image: every site asset in one file, mmapped as a unit.
+//
+// Layout: PackHeader, then header.count PackEntry records, then payloads at
+// 64-byte-aligned offsets.  Precompressed variants are entries of the same
+// name with a non-identity encoding byte; build metadata the server consumes
+// (the .preload map) rides along as kPackMeta entries.  The format is
+// written by tools/pack and read by AssetStore::load_pack; both sides
+// include this header so they cannot drift.
+#pragma once
+
+#include <cstdint>
+
+namespace vsite {
+
+constexpr char kPackMagic[4] = {'V', 'P', 'K', '2'};
+constexpr uint8_t kPackMeta = 0xff;  // non-servable metadata entry
+constexpr size_t kPackAlign = 64;
+
+struct PackHeader {
+  char magic[4];
+  uint32_t count;
+};
+
+struct PackEntry {
+  char name[72];     // NUL-terminated name within the site root
+  uint8_t encoding;  // Encoding value, or kPackMeta
+  uint8_t pad[7];
+  uint64_t offset;   // from start of image, kPackAlign-aligned
+  uint64_t size;
+  uint64_t hash;     // FNV-1a of the payload; edge sync diffs on this
+};
+static_assert(sizeof(PackHeader) == 8);
+static_assert(sizeof(PackEntry) == 104);
+
+}  // namespace vsite
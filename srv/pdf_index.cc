@@ -0,0 +1,251 @@
+#include "srv/pdf_index.h"
+
+#include <zlib.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace vsite {
+
+namespace {
+
+constexpr int kMaxPrevDepth = 16;  // /Prev chains in real files are short
+
+// Last occurrence of a token within the final window of the file.
+size_t rfind_token(std::string_view hay, std::string_view needle) {
+  return hay.rfind(needle);
+}
+
+// Reads a non-negative integer starting at p, skipping leading whitespace.
+// Returns -1 on no digits.
+long read_int(std::string_view s, size_t pos, size_t* end = nullptr) {
+  while (pos < s.size() &&
+         (s[pos] == ' ' || s[pos] == '\r' || s[pos] == '\n' ||
+          s[pos] == '\t')) {
+    pos++;
+  }
+  if (pos >= s.size() || s[pos] < '0' || s[pos] > '9') return -1;
+  long v = 0;
+  while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9') {
+    v = v * 10 + (s[pos] - '0');
+    pos++;
+  }
+  if (end != nullptr) *end = pos;
+  return v;
+}
+
+// Value of "/Key N" inside a dictionary slice, or -1.
+long dict_int(std::string_view dict, std::string_view key) {
+  size_t p = dict.find(key);
+  if (p == std::string_view::npos) return -1;
+  return read_int(dict, p + key.size());
+}
+
+// The dictionary slice starting at "<<" near pos, balanced to its ">>".
+std::string_view dict_at(std::string_view s, size_t pos) {
+  size_t open = s.find("<<", pos);
+  if (open == std::string_view::npos) return {};
+  int depth = 0;
+  for (size_t i = open; i + 1 < s.size(); i++) {
+    if (s[i] == '<' && s[i + 1] == '<') {
+      depth++;
+      i++;
+    } else if (s[i] == '>' && s[i + 1] == '>') {
+      depth--;
+      i++;
+      if (depth == 0) return s.substr(open, i + 1 - open);
+    }
+  }
+  return {};
+}
+
+}  // namespace
+
+bool PdfIndex::build(const char* data, size_t size) {
+  offsets_.clear();
+  linear_end_ = 0;
+  if (size < 32) return false;
+  std::string_view file(data, size);
+
+  // Linearization dictionary, if present, sits in the first KB:
+  // << /Linearized 1 ... /E <first page end> ... >>
+  std::string_view head = file.substr(0, file.size() < 2048 ? file.size()
+                                                            : 2048);
+  if (size_t lp = head.find("/Linearized"); lp != std::string_view::npos) {
+    std::string_view ldict = dict_at(head, head.rfind("<<", lp));
+    long e = dict_int(ldict, "/E");
+    if (e > 0) linear_end_ = static_cast<size_t>(e);
+  }
+
+  // startxref in the trailer window names the offset of the newest xref.
+  std::string_view tail =
+      file.substr(size > 1024 ? size - 1024 : 0);
+  size_t sx = rfind_token(tail, "startxref");
+  if (sx == std::string_view::npos) return false;
+  long off = read_int(tail, sx + 9);
+  if (off < 0 || static_cast<size_t>(off) >= size) return false;
+
+  return parse_xref_at(data, size, static_cast<size_t>(off), 0);
+}
+
+bool PdfIndex::parse_xref_at(const char* data, size_t size, size_t off,
+                             int depth) {
+  if (depth > kMaxPrevDepth || off >= size) return false;
+  std::string_view at(data + off, size - off);
+  // Classic tables start with the "xref" keyword; anything else here must
+  // be an "N G obj" heading a cross-reference stream.
+  size_t p = 0;
+  while (p < at.size() && (at[p] == ' ' || at[p] == '\r' || at[p] == '\n'))
+    p++;
+  if (at.substr(p, 4) == "xref") {
+    return parse_xref_table(data, size, off + p + 4, depth);
+  }
+  return parse_xref_stream(data, size, off, depth);
+}
+
+bool PdfIndex::parse_xref_table(const char* data, size_t size, size_t off,
+                                int depth) {
+  std::string_view s(data + off, size - off);
+  size_t pos = 0;
+  for (;;) {
+    size_t after;
+    long first = read_int(s, pos, &after);
+    if (first < 0) break;  // "trailer" follows the last subsection
+    long count = read_int(s, after, &after);
+    if (count < 0) return false;
+    // Skip to the first 20-byte entry line.
+    while (after < s.size() && (s[after] == '\r' || s[after] == '\n'))
+      after++;
+    for (long i = 0; i < count; i++) {
+      if (after + 20 > s.size()) return false;
+      if (s[after + 17] == 'n') {
+        offsets_.push_back(
+            static_cast<uint64_t>(std::strtoull(s.data() + after, nullptr,
+                                                10)));
+      }
+      after += 20;
+    }
+    pos = after;
+  }
+  size_t tr = s.find("trailer", pos);
+  if (tr != std::string_view::npos) {
+    std::string_view tdict = dict_at(s, tr);
+    long prev = dict_int(tdict, "/Prev");
+    if (prev > 0 && static_cast<size_t>(prev) < size) {
+      parse_xref_at(data, size, static_cast<size_t>(prev), depth + 1);
+    }
+  }
+  return !offsets_.empty();
+}
+
+bool PdfIndex::parse_xref_stream(const char* data, size_t size, size_t off,
+                                 int depth) {
+  std::string_view s(data + off, size - off);
+  std::string_view dict = dict_at(s, 0);
+  if (dict.empty() || dict.find("/XRef") == std::string_view::npos)
+    return false;
+
+  // Field widths: /W [type offset gen]; /Size bounds the object count.
+  size_t wp = dict.find("/W");
+  if (wp == std::string_view::npos) return false;
+  size_t bracket = dict.find('[', wp);
+  if (bracket == std::string_view::npos) return false;
+  size_t after;
+  long w0 = read_int(dict, bracket + 1, &after);
+  long w1 = read_int(dict, after, &after);
+  long w2 = read_int(dict, after, &after);
+  if (w0 < 0 || w1 <= 0 || w2 < 0 || w0 + w1 + w2 > 16) return false;
+
+  if (dict.find("/FlateDecode") == std::string_view::npos) return false;
+
+  size_t sp = s.find("stream", dict.data() + dict.size() - s.data());
+  if (sp == std::string_view::npos) return false;
+  sp += 6;
+  if (sp < s.size() && s[sp] == '\r') sp++;
+  if (sp < s.size() && s[sp] == '\n') sp++;
+  size_t ep = s.find("endstream", sp);
+  if (ep == std::string_view::npos) return false;
+
+  // Inflate the entry records.  /Size caps the output we accept.
+  long nobj = dict_int(dict, "/Size");
+  if (nobj <= 0 || nobj > 1 << 22) return false;
+  size_t rec = static_cast<size_t>(w0 + w1 + w2);
+
+  // Writers usually run the records through a PNG predictor before Flate
+  // (/DecodeParms /Predictor >= 10); each row then carries a leading filter
+  // byte that must be undone after inflation.
+  long predictor = dict_int(dict, "/Predictor");
+  bool png = predictor >= 10;
+  size_t row = png ? rec + 1 : rec;
+  std::string out(static_cast<size_t>(nobj) * row, '\0');
+
+  z_stream zs{};
+  if (inflateInit(&zs) != Z_OK) return false;
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(s.data() + sp));
+  zs.avail_in = ep - sp;
+  zs.next_out = reinterpret_cast<Bytef*>(out.data());
+  zs.avail_out = out.size();
+  int rc = inflate(&zs, Z_FINISH);
+  size_t produced = zs.total_out;
+  inflateEnd(&zs);
+  if (rc != Z_STREAM_END && rc != Z_OK && rc != Z_BUF_ERROR) return false;
+
+  if (png) {
+    // Unfilter in place (bytes-per-pixel is 1 for xref rows), then compact
+    // the rows so the decode loop below sees plain rec-byte records.
+    auto* buf = reinterpret_cast<uint8_t*>(out.data());
+    size_t nrows = produced / row;
+    for (size_t r2 = 0; r2 < nrows; r2++) {
+      uint8_t* cur = buf + r2 * row + 1;
+      const uint8_t* up = r2 > 0 ? cur - row : nullptr;
+      uint8_t filter = cur[-1];
+      for (size_t i = 0; i < rec; i++) {
+        uint8_t a2 = i > 0 ? cur[i - 1] : 0;
+        uint8_t b2 = up != nullptr ? up[i] : 0;
+        switch (filter) {
+          case 1: cur[i] += a2; break;                       // Sub
+          case 2: cur[i] += b2; break;                       // Up
+          case 3: cur[i] += (a2 + b2) / 2; break;            // Average
+          case 4: {                                          // Paeth
+            uint8_t c2 = (i > 0 && up != nullptr) ? up[i - 1] : 0;
+            int p = a2 + b2 - c2;
+            int pa = std::abs(p - a2), pb = std::abs(p - b2),
+                pc = std::abs(p - c2);
+            cur[i] += (pa <= pb && pa <= pc) ? a2 : (pb <= pc ? b2 : c2);
+            break;
+          }
+          default: break;                                    // None
+        }
+      }
+    }
+    for (size_t r2 = 0; r2 < nrows; r2++) {
+      std::memmove(buf + r2 * rec, buf + r2 * row + 1, rec);
+    }
+    produced = nrows * rec;
+  }
+
+  for (size_t p = 0; p + rec <= produced; p += rec) {
+    const auto* e = reinterpret_cast<const uint8_t*>(out.data() + p);
+    uint64_t type = 1;  // per spec, a zero-width type field defaults to 1
+    size_t i = 0;
+    if (w0 > 0) {
+      type = 0;
+      for (long k = 0; k < w0; k++) type = type << 8 | e[i++];
+    }
+    uint64_t field2 = 0;
+    for (long k = 0; k < w1; k++) field2 = field2 << 8 | e[i++];
+    if (type == 1 && field2 < size) offsets_.push_back(field2);
+    // type 2 entries live inside object streams; their containers are
+    // already covered by their own type 1 entries.
+  }
+
+  long prev = dict_int(dict, "/Prev");
+  if (prev > 0 && static_cast<size_t>(prev) < size && prev != (long)off) {
+    parse_xref_at(data, size, static_cast<size_t>(prev), depth + 1);
+  }
+  return !offsets_.empty();
+}
+
+}  // namespace vsite
@@ -0,0 +1,49 @@
+// Startup-built index of a PDF's cross-reference data.
+//
+// Built once per mapping generation for the CV so ranged serving decisions
+// cost nothing per request.  Two things come out of the parse:
+//
+//  * the object offset table, from the classic xref table or a PDF 1.5
+//    cross-reference stream (FlateDecode via zlib), following /Prev chains;
+//  * the linearization extent /E when the file is linearized, i.e. the byte
+//    count a viewer needs to render page one.
+//
+// A malformed or unsupported file simply yields an empty index; Range
+// requests still work, we just cannot clamp open-ended reads to page one.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace vsite {
+
+class PdfIndex {
+ public:
+  // Parses the mapped file.  Returns false (leaving the index empty) when
+  // the xref could not be understood; never throws, never over-reads.
+  bool build(const char* data, size_t size);
+
+  size_t object_count() const { return offsets_.size(); }
+  const std::vector<uint64_t>& offsets() const { return offsets_; }
+
+  // Bytes from the start of the file sufficient to render the first page,
+  // or file_size when the PDF is not linearized.
+  size_t first_page_extent(size_t file_size) const {
+    return linear_end_ > 0 && linear_end_ <= file_size ? linear_end_
+                                                       : file_size;
+  }
+  bool linearized() const { return linear_end_ > 0; }
+
+ private:
+  bool parse_xref_at(const char* data, size_t size, size_t off, int depth);
+  bool parse_xref_table(const char* data, size_t size, size_t off,
+                        int depth);
+  bool parse_xref_stream(const char* data, size_t size, size_t off,
+                         int depth);
+
+  std::vector<uint64_t> offsets_;
+  size_t linear_end_ = 0;
+};
+
+}  // namespace vsite
@@ -0,0 +1,85 @@
+// Per-core token-bucket admission control.
+//
+// Each event loop owns one limiter: a fixed open-addressing table of
+// per-source buckets, so the whole thing is shared-nothing -- no locks,
+// no allocation, no cache line ever crossing cores.  A lookup is a
+// multiplicative hash plus a short linear probe; refill is integer math
+// off the loop's monotonic clock.  When the probe window is full the
+// stalest bucket is recycled, which can only ever forgive an abuser,
+// never punish a fresh source.
+//
+// Admission is charged twice on purpose: once at accept (an over-limit
+// source costs one close(), nothing is allocated) and once per request
+// (a keep-alive connection cannot ride a single admit forever; the
+// over-limit answer is a canned 429-and-close, far cheaper than the
+// response it replaces).
+#pragma once
+
+#include <cstdint>
+
+namespace vsite {
+
+class RateLimiter {
+ public:
+  // per_sec tokens per source per second, bursting to 4x; 0 disables.
+  void configure(uint32_t per_sec) {
+    rate_ = per_sec;
+    burst_ = per_sec * 4;
+  }
+  bool enabled() const { return rate_ != 0; }
+
+  // True when the source may proceed (one token consumed).  ip is the
+  // peer's IPv4 address in network order; never zero for a real peer.
+  bool admit(uint32_t ip, uint64_t now_ns) {
+    if (rate_ == 0) return true;
+    uint32_t idx = (ip * 0x9e3779b1u) & (kSlots - 1);
+    uint32_t victim = idx;
+    for (uint32_t i = 0; i < kProbes; i++) {
+      Bucket& b = slots_[(idx + i) & (kSlots - 1)];
+      if (b.ip == ip) {
+        // Integer refill: elapsed nanoseconds times rate, whole tokens
+        // only, remainder carried implicitly by advancing last_ns in
+        // token-sized steps.
+        uint64_t earned = (now_ns - b.last_ns) * rate_ / 1000000000ull;
+        if (earned > 0) {
+          b.tokens = b.tokens + earned < burst_
+                         ? b.tokens + static_cast<uint32_t>(earned)
+                         : burst_;
+          b.last_ns += earned * 1000000000ull / rate_;
+          if (b.tokens == burst_) b.last_ns = now_ns;
+        }
+        if (b.tokens == 0) return false;
+        b.tokens--;
+        return true;
+      }
+      if (b.ip == 0) {
+        victim = (idx + i) & (kSlots - 1);
+        break;
+      }
+      if (b.last_ns < slots_[victim].last_ns) {
+        victim = (idx + i) & (kSlots - 1);
+      }
+    }
+    Bucket& b = slots_[victim];
+    b.ip = ip;
+    b.tokens = burst_ - 1;
+    b.last_ns = now_ns;
+    return true;
+  }
+
+ private:
+  struct Bucket {
+    uint32_t ip = 0;       // network order; 0 marks an empty slot
+    uint32_t tokens = 0;
+    uint64_t last_ns = 0;
+  };
+
+  static constexpr uint32_t kSlots = 4096;  // 64 KiB per shard
+  static constexpr uint32_t kProbes = 8;
+
+  uint32_t rate_ = 0;
+  uint32_t burst_ = 0;
+  Bucket slots_[kSlots];
+};
+
+}  // namespace vsite
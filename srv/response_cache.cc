@@ -0,0 +1,339 @@
+#include "srv/response_cache.h"
+
+#include "srv/delta.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace vsite {
+
+uint64_t fnv1a64(const void* data, size_t len) {
+  const auto* p = static_cast<const uint8_t*>(data);
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < len; i++) {
+    h ^= p[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+namespace {
+
+// Content-addressed names (stem.<16 hex>.ext, as emitted by the build
+// pipeline) can never serve stale bytes, so they get a year of immutable
+// caching; mutable names revalidate after five minutes.
+bool is_hashed_name(const std::string& name) {
+  size_t last = name.rfind('.');
+  if (last == std::string::npos || last == 0) return false;
+  size_t prev = name.rfind('.', last - 1);
+  if (prev == std::string::npos || last - prev - 1 != 16) return false;
+  for (size_t i = prev + 1; i < last; i++) {
+    char ch = name[i];
+    if (!((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'f')))
+      return false;
+  }
+  return true;
+}
+
+// Wire-level intern shared across every cache in the process.  Sites whose
+// stores dedup'd a mapping build byte-identical entries for it (same body,
+// so same ETag and headers); interning collapses those into one buffer, the
+// response-side half of multi-site memory scaling with unique bytes.  Weak
+// entries expire with their last cache slot.  Entries are only built from
+// the loading thread, so no lock.
+std::map<uint64_t, std::vector<std::weak_ptr<const Response>>> g_responses;
+
+ResponseRef intern_response(ResponseRef r) {
+  auto& cands = g_responses[fnv1a64(r->wire.data(), r->wire.size())];
+  for (auto it = cands.begin(); it != cands.end();) {
+    if (ResponseRef prev = it->lock()) {
+      if (prev->wire == r->wire && prev->header_len == r->header_len) {
+        return prev;
+      }
+      ++it;
+    } else {
+      it = cands.erase(it);
+    }
+  }
+  cands.push_back(r);
+  return r;
+}
+
+ResponseRef build_entry(const Asset& a, Encoding e, const Mapping& m) {
+  auto r = std::make_shared<Response>();
+
+  char etag[24];
+  std::snprintf(etag, sizeof(etag), "\"%016llx\"",
+                static_cast<unsigned long long>(fnv1a64(m.data, m.size)));
+  r->etag = etag;
+
+  char enc_hdr[64] = "";
+  if (e != Encoding::kIdentity) {
+    std::snprintf(enc_hdr, sizeof(enc_hdr), "Content-Encoding: %s\r\n",
+                  encoding_name(e));
+  }
+  // No Connection header: HTTP/1.1 defaults to keep-alive, and the server
+  // closes the socket itself for 1.0 clients and "Connection: close", so
+  // one prebuilt buffer serves both cases.
+  char hdr[512];
+  int n = std::snprintf(hdr, sizeof(hdr),
+                        "HTTP/1.1 200 OK\r\n"
+                        "Content-Type: %s\r\n"
+                        "Content-Length: %zu\r\n"
+                        "%s"
+                        "ETag: %s\r\n"
+                        "Cache-Control: %s\r\n"
+                        "Accept-Ranges: bytes\r\n"
+                        "Vary: Accept-Encoding\r\n"
+                        "\r\n",
+                        a.content_type.c_str(), m.size, enc_hdr,
+                        r->etag.c_str(),
+                        is_hashed_name(a.file_path)
+                            ? "public, max-age=31536000, immutable"
+                            : "max-age=300");
+  r->header_len = static_cast<size_t>(n);
+  r->wire.reserve(r->header_len + m.size);
+  r->wire.assign(hdr, n);
+  r->wire.append(m.data, m.size);
+  return r;
+}
+
+ResponseRef build_not_found() {
+  static const char kBody[] = "not found\n";
+  auto r = std::make_shared<Response>();
+  char hdr[160];
+  int n = std::snprintf(hdr, sizeof(hdr),
+                        "HTTP/1.1 404 Not Found\r\n"
+                        "Content-Type: text/plain; charset=utf-8\r\n"
+                        "Content-Length: %zu\r\n"
+                        "\r\n",
+                        sizeof(kBody) - 1);
+  r->header_len = static_cast<size_t>(n);
+  r->wire.assign(hdr, n);
+  r->wire.append(kBody, sizeof(kBody) - 1);
+  return r;
+}
+
+// The revalidation answer mirrors the headers a 200 would carry so caches
+// refresh their lifetime, but has no body to stream.
+ResponseRef build_not_modified(const Asset& a, const Response& full) {
+  auto r = std::make_shared<Response>();
+  char hdr[256];
+  int n = std::snprintf(hdr, sizeof(hdr),
+                        "HTTP/1.1 304 Not Modified\r\n"
+                        "ETag: %s\r\n"
+                        "Cache-Control: %s\r\n"
+                        "Vary: Accept-Encoding\r\n"
+                        "\r\n",
+                        full.etag.c_str(),
+                        is_hashed_name(a.file_path)
+                            ? "public, max-age=31536000, immutable"
+                            : "max-age=300");
+  r->header_len = static_cast<size_t>(n);
+  r->etag = full.etag;
+  r->wire.assign(hdr, n);
+  return r;
+}
+
+// Beacon acknowledgement: headers only, served from memory in the same
+// lookup-plus-write motion as everything else.
+ResponseRef build_no_content() {
+  auto r = std::make_shared<Response>();
+  static const char kWire[] =
+      "HTTP/1.1 204 No Content\r\n"
+      "Cache-Control: no-store\r\n"
+      "\r\n";
+  r->wire.assign(kWire, sizeof(kWire) - 1);
+  r->header_len = r->wire.size();
+  return r;
+}
+
+ResponseRef build_too_many() {
+  static const char kBody[] = "too many requests\n";
+  auto r = std::make_shared<Response>();
+  char hdr[200];
+  int n = std::snprintf(hdr, sizeof(hdr),
+                        "HTTP/1.1 429 Too Many Requests\r\n"
+                        "Content-Type: text/plain; charset=utf-8\r\n"
+                        "Content-Length: %zu\r\n"
+                        "Retry-After: 1\r\n"
+                        "Connection: close\r\n"
+                        "\r\n",
+                        sizeof(kBody) - 1);
+  r->header_len = static_cast<size_t>(n);
+  r->wire.assign(hdr, n);
+  r->wire.append(kBody, sizeof(kBody) - 1);
+  return r;
+}
+
+}  // namespace
+
+ResponseRef build_range_response(const Asset& a, const Mapping& m,
+                                 size_t first, size_t last) {
+  auto r = std::make_shared<Response>();
+  size_t len = last - first + 1;
+  char hdr[512];
+  int n = std::snprintf(hdr, sizeof(hdr),
+                        "HTTP/1.1 206 Partial Content\r\n"
+                        "Content-Type: %s\r\n"
+                        "Content-Length: %zu\r\n"
+                        "Content-Range: bytes %zu-%zu/%zu\r\n"
+                        "Accept-Ranges: bytes\r\n"
+                        "\r\n",
+                        a.content_type.c_str(), len, first, last, m.size);
+  r->header_len = static_cast<size_t>(n);
+  r->wire.reserve(r->header_len + len);
+  r->wire.assign(hdr, n);
+  r->wire.append(m.data + first, len);
+  return r;
+}
+
+ResponseRef build_range_unsatisfiable(size_t file_size) {
+  auto r = std::make_shared<Response>();
+  char hdr[160];
+  int n = std::snprintf(hdr, sizeof(hdr),
+                        "HTTP/1.1 416 Range Not Satisfiable\r\n"
+                        "Content-Range: bytes */%zu\r\n"
+                        "Content-Length: 0\r\n"
+                        "\r\n",
+                        file_size);
+  r->header_len = static_cast<size_t>(n);
+  r->wire.assign(hdr, n);
+  return r;
+}
+
+void ResponseCache::build_all(AssetStore& store) {
+  store_ = &store;
+  std::atomic_store(&not_found_, build_not_found());
+  std::atomic_store(&too_many_, build_too_many());
+  std::atomic_store(&no_content_, build_no_content());
+  for (const Asset& a : store.assets()) rebuild(a);
+}
+
+void ResponseCache::rebuild(const Asset& a) {
+  int idx = index_of(a);
+  if (idx < 0) return;
+  for (int e = 0; e < kNumEncodings; e++) {
+    ResponseRef entry, nm;
+    if (MappingRef m = a.current(static_cast<Encoding>(e))) {
+      entry = intern_response(build_entry(a, static_cast<Encoding>(e), *m));
+      nm = build_not_modified(a, *entry);
+    }
+    std::atomic_store(&entries_[idx][e], std::move(entry));
+    std::atomic_store(&nm_[idx][e], std::move(nm));
+  }
+  // New bytes invalidate every cached delta this asset takes part in,
+  // as base or as target.
+  for (int i = 0; i < kMaxAssets; i++) {
+    std::atomic_store(&deltas_[idx][i], ResponseRef());
+    std::atomic_store(&deltas_[i][idx], ResponseRef());
+  }
+
+  ResponseRef hints;
+  if (const auto* targets = store_->preload_targets(a.file_path);
+      targets != nullptr && !targets->empty()) {
+    auto h = std::make_shared<Response>();
+    h->wire = "HTTP/1.1 103 Early Hints\r\n";
+    for (const std::string& t : *targets) {
+      h->wire += "Link: </" + t + ">; rel=preload; as=style\r\n";
+    }
+    h->wire += "\r\n";
+    h->header_len = h->wire.size();
+    hints = std::move(h);
+  }
+  std::atomic_store(&hints_[idx], std::move(hints));
+}
+
+ResponseRef ResponseCache::early_hints(const Asset& a) const {
+  int idx = index_of(a);
+  if (idx < 0) return nullptr;
+  return std::atomic_load(&hints_[idx]);
+}
+
+ResponseRef ResponseCache::get(const Asset& a, Encoding e) const {
+  int idx = index_of(a);
+  if (idx < 0) return nullptr;
+  return std::atomic_load(&entries_[idx][static_cast<int>(e)]);
+}
+
+ResponseRef ResponseCache::not_modified(const Asset& a, Encoding e) const {
+  int idx = index_of(a);
+  if (idx < 0) return nullptr;
+  return std::atomic_load(&nm_[idx][static_cast<int>(e)]);
+}
+
+ResponseRef ResponseCache::delta_response(const Asset& a,
+                                          std::string_view base_etag) {
+  int tgt = index_of(a);
+  if (tgt < 0 || base_etag.empty() || store_ == nullptr) return nullptr;
+
+  // The base is whichever asset's identity ETag the client quoted.
+  auto& assets = const_cast<AssetStore*>(store_)->assets();
+  int base = -1;
+  for (size_t i = 0; i < assets.size() && i < kMaxAssets; i++) {
+    ResponseRef e = std::atomic_load(&entries_[i][0]);
+    if (e && base_etag.find(e->etag) != std::string_view::npos) {
+      base = static_cast<int>(i);
+      break;
+    }
+  }
+  if (base < 0 || base == tgt) return nullptr;
+
+  if (ResponseRef cached = std::atomic_load(&deltas_[base][tgt])) {
+    return cached;
+  }
+
+  ResponseRef be = std::atomic_load(&entries_[base][0]);
+  ResponseRef te = std::atomic_load(&entries_[tgt][0]);
+  if (!be || !te) return nullptr;
+  std::string_view base_body(be->wire.data() + be->header_len,
+                             be->wire.size() - be->header_len);
+  std::string_view tgt_body(te->wire.data() + te->header_len,
+                            te->wire.size() - te->header_len);
+  // Deltas only make sense between documents; never against a 100 KB PDF.
+  if (a.content_type.rfind("text/", 0) != 0 &&
+      a.content_type.rfind("application/xml", 0) != 0) {
+    return nullptr;
+  }
+
+  std::string delta = delta_encode(base_body, tgt_body);
+  // Not worth a round trip unless it beats the full body decisively.
+  if (delta.size() * 2 >= tgt_body.size()) return nullptr;
+
+  auto r = std::make_shared<Response>();
+  char hdr[320];
+  int n = std::snprintf(hdr, sizeof(hdr),
+                        "HTTP/1.1 226 IM Used\r\n"
+                        "IM: vsite-bdiff\r\n"
+                        "ETag: %s\r\n"
+                        "Delta-Base: %s\r\n"
+                        "Content-Type: application/octet-stream\r\n"
+                        "Content-Length: %zu\r\n"
+                        "Cache-Control: no-store\r\n"
+                        "\r\n",
+                        te->etag.c_str(), be->etag.c_str(), delta.size());
+  r->header_len = static_cast<size_t>(n);
+  r->etag = te->etag;
+  r->wire.reserve(r->header_len + delta.size());
+  r->wire.assign(hdr, n);
+  r->wire += delta;
+  ResponseRef ref = std::move(r);
+  // Races just compute the same bytes twice; last writer wins.
+  std::atomic_store(&deltas_[base][tgt], ref);
+  return ref;
+}
+
+int ResponseCache::index_of(const Asset& a) const {
+  if (store_ == nullptr) return -1;
+  auto& v = const_cast<AssetStore*>(store_)->assets();
+  ptrdiff_t idx = &a - v.data();
+  if (idx < 0 || idx >= static_cast<ptrdiff_t>(v.size()) ||
+      idx >= kMaxAssets) {
+    return -1;
+  }
+  return static_cast<int>(idx);
+}
+
+}  // namespace vsite
@@ -0,0 +1,91 @@
+// Response cache: complete wire-format responses, prebuilt once per asset
+// generation.
+//
+// For every asset and every encoding variant present on disk we assemble the
+// full byte sequence that goes on the wire -- status line, headers and body
+// in one contiguous buffer -- at load time.  The hot path is then a lookup
+// plus a single write; no header formatting, no hashing, no allocation per
+// request.  ETags are FNV-1a hashes of the body computed once here, never
+// per hit.
+//
+// Entries are immutable and handed out as shared_ptrs, the same generation
+// scheme AssetStore uses for mappings: a rebuild after a deploy swaps the
+// entry while in-flight responses keep streaming the old bytes.
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "srv/asset_store.h"
+
+namespace vsite {
+
+struct Response {
+  std::string wire;       // headers + body, ready for write()
+  size_t header_len = 0;  // HEAD sends only this prefix
+  std::string etag;       // quoted, e.g. "\"a1b2c3d4e5f60718\""
+};
+
+using ResponseRef = std::shared_ptr<const Response>;
+
+// Stable FNV-1a 64-bit; also the basis for ETag values, so it must not
+// change across builds or variants stop revalidating.
+uint64_t fnv1a64(const void* data, size_t len);
+
+// Built on demand for Range requests -- the rare path, so these are not
+// cached.  [first, last] is an inclusive, already-validated byte range.
+ResponseRef build_range_response(const Asset& a, const Mapping& m,
+                                 size_t first, size_t last);
+ResponseRef build_range_unsatisfiable(size_t file_size);
+
+class ResponseCache {
+ public:
+  // Builds entries for every asset/encoding in the store.  Call once after
+  // AssetStore::load() and again (per asset) when a file is remapped.
+  void build_all(AssetStore& store);
+  void rebuild(const Asset& a);
+
+  // The prebuilt response, or null when the asset lacks that variant.
+  ResponseRef get(const Asset& a, Encoding e) const;
+
+  // Prebuilt 304 for the variant -- status line, ETag and caching headers,
+  // no body -- served when If-None-Match carries the variant's ETag.
+  ResponseRef not_modified(const Asset& a, Encoding e) const;
+
+  // 226 delta response rebuilding a (identity bytes) from the asset whose
+  // identity ETag equals base_etag, or null when the base is unknown or
+  // the delta would not pay for itself.  Deltas are computed lazily and
+  // cached per (base, target) pair; rebuilds invalidate both directions.
+  ResponseRef delta_response(const Asset& a, std::string_view base_etag);
+
+  // Prebuilt "103 Early Hints" interim response carrying the page's preload
+  // links, or null when the build recorded none.  Sent ahead of the 200 so
+  // the client starts fetching subresources before the HTML lands.
+  ResponseRef early_hints(const Asset& a) const;
+
+  // Canned 404, same contiguous-buffer shape as asset hits.
+  ResponseRef not_found() const { return std::atomic_load(&not_found_); }
+
+  // Canned 429 for over-limit sources; carries Connection: close because
+  // the server drops the connection after sending it.
+  ResponseRef too_many() const { return std::atomic_load(&too_many_); }
+
+  // Canned 204 acknowledging an accepted beacon POST.
+  ResponseRef no_content() const { return std::atomic_load(&no_content_); }
+
+ private:
+  int index_of(const Asset& a) const;
+
+  static constexpr int kMaxAssets = AssetStore::kMaxAssets;
+  ResponseRef entries_[kMaxAssets][kNumEncodings];
+  ResponseRef nm_[kMaxAssets][kNumEncodings];
+  ResponseRef deltas_[kMaxAssets][kMaxAssets];
+  ResponseRef hints_[kMaxAssets];
+  ResponseRef not_found_;
+  ResponseRef too_many_;
+  ResponseRef no_content_;
+  const AssetStore* store_ = nullptr;
+};
+
+}  // namespace vsite
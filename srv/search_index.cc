@@ -0,0 +1,200 @@
+#include "srv/search_index.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace vsite {
+
+SearchIndex::~SearchIndex() {
+  if (base_ != nullptr) {
+    munmap(const_cast<char*>(base_), size_);
+  }
+}
+
+bool SearchIndex::load(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  struct stat st{};
+  if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) <
+                                sizeof(SearchHeader)) {
+    close(fd);
+    return false;
+  }
+  void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return false;
+
+  const auto* hdr = static_cast<const SearchHeader*>(p);
+  const char* base = static_cast<const char*>(p);
+  size_t size = st.st_size;
+  // Bounds are validated once here so query() can trust every offset:
+  // section extents first, then every term string, posting run and page
+  // name.  String offsets only need to land inside the blob because the
+  // blob's final byte must be NUL, so any in-range string terminates
+  // before the mapping ends.  A file that fails any check is refused
+  // whole -- same posture as delta_decode.
+  bool ok = std::memcmp(hdr->magic, kSearchMagic, 4) == 0 &&
+            hdr->blob_off <= size &&
+            hdr->pages_off + hdr->page_count * sizeof(uint32_t) <=
+                hdr->terms_off &&
+            hdr->terms_off + hdr->term_count * sizeof(SearchTerm) <=
+                hdr->postings_off &&
+            hdr->postings_off <= hdr->blob_off;
+  if (ok) {
+    size_t blob_size = size - hdr->blob_off;
+    size_t posting_slots =
+        (hdr->blob_off - hdr->postings_off) / sizeof(SearchPosting);
+    if ((hdr->term_count > 0 || hdr->page_count > 0) &&
+        (blob_size == 0 || base[size - 1] != '\0')) {
+      ok = false;
+    }
+    const auto* terms =
+        reinterpret_cast<const SearchTerm*>(base + hdr->terms_off);
+    for (uint32_t t = 0; ok && t < hdr->term_count; t++) {
+      if (terms[t].str_off >= blob_size ||
+          static_cast<size_t>(terms[t].post_off) + terms[t].post_count >
+              posting_slots) {
+        ok = false;
+      }
+    }
+    const auto* offs =
+        reinterpret_cast<const uint32_t*>(base + hdr->pages_off);
+    for (uint32_t pg = 0; ok && pg < hdr->page_count; pg++) {
+      if (offs[pg] >= blob_size) ok = false;
+    }
+  }
+  if (!ok) {
+    munmap(p, size);
+    return false;
+  }
+  base_ = static_cast<const char*>(p);
+  size_ = size;
+  hdr_ = hdr;
+  return true;
+}
+
+const char* SearchIndex::term_str(uint32_t i) const {
+  const auto* terms = reinterpret_cast<const SearchTerm*>(
+      base_ + hdr_->terms_off);
+  return base_ + hdr_->blob_off + terms[i].str_off;
+}
+
+const char* SearchIndex::page_name(uint32_t page) const {
+  if (hdr_ == nullptr || page >= hdr_->page_count) return "";
+  const auto* offs = reinterpret_cast<const uint32_t*>(
+      base_ + hdr_->pages_off);
+  return base_ + hdr_->blob_off + offs[page];
+}
+
+int SearchIndex::query(std::string_view prefix, Hit* out,
+                       int max_hits) const {
+  if (hdr_ == nullptr || prefix.empty() || max_hits <= 0) return 0;
+
+  // Lower bound of the prefix run in the sorted dictionary.
+  uint32_t lo = 0, hi = hdr_->term_count;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (std::string_view(term_str(mid)) < prefix) lo = mid + 1;
+    else hi = mid;
+  }
+
+  // One score slot per page, on the stack; the format caps pages at
+  // 16 bits but the site is nowhere near even this.
+  constexpr uint32_t kMaxPages = 256;
+  uint32_t scores[kMaxPages] = {};
+  uint32_t pages = hdr_->page_count < kMaxPages ? hdr_->page_count
+                                                : kMaxPages;
+  const auto* terms = reinterpret_cast<const SearchTerm*>(
+      base_ + hdr_->terms_off);
+  const auto* postings = reinterpret_cast<const SearchPosting*>(
+      base_ + hdr_->postings_off);
+  for (uint32_t t = lo; t < hdr_->term_count; t++) {
+    std::string_view term(term_str(t));
+    if (term.substr(0, prefix.size()) != prefix) break;
+    for (uint16_t i = 0; i < terms[t].post_count; i++) {
+      const SearchPosting& p = postings[terms[t].post_off + i];
+      if (p.page < pages) scores[p.page] += p.count;
+    }
+  }
+
+  // Selection over a handful of pages; sorting machinery would cost more
+  // than it saves.
+  int n = 0;
+  for (int k = 0; k < max_hits; k++) {
+    uint32_t best = 0, best_page = pages;
+    for (uint32_t pg = 0; pg < pages; pg++) {
+      if (scores[pg] > best) {
+        best = scores[pg];
+        best_page = pg;
+      }
+    }
+    if (best_page == pages) break;
+    out[n].page = static_cast<uint16_t>(best_page);
+    out[n].score = best;
+    n++;
+    scores[best_page] = 0;
+  }
+  return n;
+}
+
+ResponseRef build_search_response(const SearchIndex& idx,
+                                  std::string_view raw_query) {
+  // Decode and sanitize: %xx and '+' resolved, lowercased, anything
+  // outside [a-z0-9] ends the term.  One term, bounded length.
+  char q[64];
+  size_t qlen = 0;
+  for (size_t i = 0; i < raw_query.size() && qlen < sizeof(q); i++) {
+    char c = raw_query[i];
+    if (c == '&') break;
+    if (c == '+') c = ' ';
+    if (c == '%' && i + 2 < raw_query.size()) {
+      auto hex = [](char h) -> int {
+        if (h >= '0' && h <= '9') return h - '0';
+        if (h >= 'a' && h <= 'f') return h - 'a' + 10;
+        if (h >= 'A' && h <= 'F') return h - 'A' + 10;
+        return -1;
+      };
+      int hi = hex(raw_query[i + 1]), lo = hex(raw_query[i + 2]);
+      if (hi >= 0 && lo >= 0) {
+        c = static_cast<char>(hi * 16 + lo);
+        i += 2;
+      }
+    }
+    if (c >= 'A' && c <= 'Z') c = static_cast<char>(c | 0x20);
+    if (!((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9'))) break;
+    q[qlen++] = c;
+  }
+
+  SearchIndex::Hit hits[10];
+  int n = idx.query({q, qlen}, hits, 10);
+
+  std::string body = "{\"hits\":[";
+  for (int i = 0; i < n; i++) {
+    char item[160];
+    std::snprintf(item, sizeof(item),
+                  "%s{\"page\":\"%s\",\"score\":%u}", i > 0 ? "," : "",
+                  idx.page_name(hits[i].page), hits[i].score);
+    body += item;
+  }
+  body += "]}\n";
+
+  auto r = std::make_shared<Response>();
+  char hdr[160];
+  int hn = std::snprintf(hdr, sizeof(hdr),
+                         "HTTP/1.1 200 OK\r\n"
+                         "Content-Type: application/json\r\n"
+                         "Content-Length: %zu\r\n"
+                         "Cache-Control: no-store\r\n"
+                         "\r\n",
+                         body.size());
+  r->header_len = static_cast<size_t>(hn);
+  r->wire.assign(hdr, hn);
+  r->wire += body;
+  return r;
+}
+
+}  // namespace vsite
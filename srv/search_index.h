@@ -0,0 +1,96 @@
+// Memory-mapped prefix-search index over the site's text.
+//
+// The generator (tools/mkindex) tokenizes the built pages and the PDF's
+// text into a sorted term dictionary with per-page postings, laid out as
+// fixed-width records over one string blob so the whole index is usable
+// directly from the mapping -- no parse step, no heap image.  A query is
+// two binary searches bounding the prefix run plus a walk over its
+// postings, accumulating scores in a caller-sized stack array: zero
+// allocation, microseconds for any prefix this site can produce.
+//
+// A sorted dictionary was chosen over an FST: at this corpus size the
+// whole index is a few kilobytes, transducer compression would save
+// nothing measurable, and binary search keeps the format auditable with
+// a hex dump.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "srv/response_cache.h"
+
+namespace vsite {
+
+// On-disk layout, little-endian, offsets from the start of the file:
+//
+//   SearchHeader
+//   uint32_t page_name_off[page_count]   -- blob offsets, NUL-terminated
+//   SearchTerm[term_count]               -- sorted by term string
+//   SearchPosting[...]
+//   blob
+constexpr char kSearchMagic[4] = {'V', 'S', 'X', '1'};
+
+struct SearchHeader {
+  char magic[4];
+  uint32_t page_count;
+  uint32_t term_count;
+  uint32_t pages_off;
+  uint32_t terms_off;
+  uint32_t postings_off;
+  uint32_t blob_off;
+  uint32_t pad;
+};
+static_assert(sizeof(SearchHeader) == 32);
+
+struct SearchTerm {
+  uint32_t str_off;     // into the blob, NUL-terminated
+  uint32_t post_off;    // index of the first posting
+  uint16_t post_count;
+  uint16_t pad;
+};
+static_assert(sizeof(SearchTerm) == 12);
+
+struct SearchPosting {
+  uint16_t page;   // index into the page name table
+  uint16_t count;  // term occurrences in that page
+};
+static_assert(sizeof(SearchPosting) == 4);
+
+class SearchIndex {
+ public:
+  ~SearchIndex();
+
+  // Maps the index file.  A missing or malformed file leaves the index
+  // empty and query() returning nothing; search is optional equipment.
+  bool load(const std::string& path);
+  bool loaded() const { return base_ != nullptr; }
+
+  struct Hit {
+    uint16_t page;
+    uint32_t score;
+  };
+
+  // Pages matching the prefix, best first, scored by summed occurrence
+  // counts across all terms in the prefix run.  Writes at most max_hits
+  // into out and returns how many; allocates nothing.
+  int query(std::string_view prefix, Hit* out, int max_hits) const;
+
+  const char* page_name(uint32_t page) const;
+  uint32_t page_count() const { return hdr_ != nullptr ? hdr_->page_count : 0; }
+
+ private:
+  const char* term_str(uint32_t i) const;
+
+  const char* base_ = nullptr;
+  size_t size_ = 0;
+  const SearchHeader* hdr_ = nullptr;
+};
+
+// JSON response for a "/search?q=..." request (raw_query is the bytes
+// after "q=", percent-decoded and lowercased here).  Built per query like
+// Range responses are -- search is the rare path next to page serving.
+ResponseRef build_search_response(const SearchIndex& idx,
+                                  std::string_view raw_query);
+
+}  // namespace vsite
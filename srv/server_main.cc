@@ -0,0 +1,240 @@
+// vsrvd: the site's serving core.
+//
+// One EventLoop per core (SO_REUSEPORT sharding), each with its own arena
+// and connection pool so nothing on the request path crosses cores or calls
+// malloc.  Every asset/encoding pair has its complete wire-format response
+// prebuilt by ResponseCache, so serving index.html is one lookup and one
+// write.  AssetStore remaps on deploy without dropping in-flight responses.
+//
+//   usage: vsrvd [-p port] [-r site_root ... | -P site.pack] [-j shards]
+//
+// Repeating -r serves several sites from one process, routed by Host; each
+// root's CNAME file names its site, and the first root is the fallback for
+// unmatched hosts.  Identical bytes across sites are stored and cached
+// once (see srv/site_set.h).
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "srv/access_log.h"
+#include "srv/asset_store.h"
+#include "srv/beacon.h"
+#include "srv/event_loop.h"
+#include "srv/handoff.h"
+#include "srv/response_cache.h"
+#include "srv/search_index.h"
+#include "srv/site_set.h"
+#include "srv/stats.h"
+#include "srv/tls.h"
+#include "srv/uring_loop.h"
+
+int main(int argc, char** argv) {
+  uint16_t port = 8080;
+  std::vector<std::string> roots;
+  std::string pack;
+  std::string cert, key;
+  std::string backend = "epoll";
+  std::string log_path;
+  std::string handoff_path;
+  std::string beacon_dir;
+  int shards = 1;
+  int rate_limit = 0;  // requests per source per second; 0 = off
+  uint16_t admin_port = 0;
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+      port = static_cast<uint16_t>(std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+      roots.push_back(argv[++i]);
+    } else if (std::strcmp(argv[i], "-P") == 0 && i + 1 < argc) {
+      pack = argv[++i];
+    } else if (std::strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+      cert = argv[++i];
+    } else if (std::strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+      key = argv[++i];
+    } else if (std::strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+      admin_port = static_cast<uint16_t>(std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+      backend = argv[++i];
+    } else if (std::strcmp(argv[i], "-L") == 0 && i + 1 < argc) {
+      log_path = argv[++i];
+    } else if (std::strcmp(argv[i], "-U") == 0 && i + 1 < argc) {
+      handoff_path = argv[++i];
+    } else if (std::strcmp(argv[i], "-B") == 0 && i + 1 < argc) {
+      beacon_dir = argv[++i];
+    } else if (std::strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+      rate_limit = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+      shards = std::atoi(argv[++i]);
+      // "-j 0" means one shard per core.
+      if (shards <= 0) shards = std::thread::hardware_concurrency();
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [-p port] [-r site_root ... | -P site.pack]"
+                   " [-j shards] [-b epoll|uring] [-a admin_port]"
+                   " [-L access.blog] [-U handoff.sock] [-R req_per_sec]"
+                   " [-B beacon_dir] [-c cert.pem -k key.pem]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  if (!pack.empty() && !roots.empty()) {
+    std::fprintf(stderr, "vsrvd: -P and -r are mutually exclusive\n");
+    return 2;
+  }
+  if (roots.empty()) roots.push_back(".");
+
+  // Every configuration is a SiteSet; a single root (or pack) is just the
+  // one-site case, where Host routing is bypassed entirely.  The search
+  // index is directory mode only (the pack carries servable assets, not
+  // dotfiles).
+  vsite::SiteSet sites;
+  if (!pack.empty()) {
+    sites.add(".", pack);  // one mmap; deploys swap the whole generation
+  } else {
+    for (const std::string& r : roots) sites.add(r);
+  }
+  vsite::AssetStore& store = sites.site(0).store;
+  vsite::ResponseCache& cache = sites.site(0).cache;
+  vsite::SearchIndex& search = sites.site(0).search;
+  vsite::SiteSet* routed = sites.size() > 1 ? &sites : nullptr;
+
+  for (size_t i = 0; i < sites.size(); i++) {
+    const vsite::Site& s = sites.site(i);
+    if (s.search.loaded()) {
+      std::fprintf(stderr, "vsrvd: %s: search index loaded, %u pages\n",
+                   s.root.c_str(), s.search.page_count());
+    }
+    if (routed != nullptr) {
+      std::string hosts;
+      for (const std::string& h : s.hosts) {
+        hosts += hosts.empty() ? h : ", " + h;
+      }
+      std::fprintf(stderr, "vsrvd: site %s: %s%s\n", s.root.c_str(),
+                   hosts.empty() ? "(no CNAME)" : hosts.c_str(),
+                   i == 0 ? " [fallback]" : "");
+    }
+  }
+
+  vsite::TlsContext tls;
+  if (!cert.empty() && !key.empty()) tls.init(cert, key);
+
+  bool use_uring = backend == "uring";
+  if (use_uring && !vsite::UringLoop::available()) {
+    std::fprintf(stderr,
+                 "vsrvd: built without liburing, using epoll backend\n");
+    use_uring = false;
+  }
+  if (use_uring && tls.enabled()) {
+    std::fprintf(stderr, "vsrvd: TLS requires the epoll backend\n");
+    return 2;
+  }
+  if (use_uring && !handoff_path.empty()) {
+    std::fprintf(stderr, "vsrvd: handoff requires the epoll backend\n");
+    return 2;
+  }
+  if (use_uring && routed != nullptr) {
+    std::fprintf(stderr, "vsrvd: multi-site requires the epoll backend\n");
+    return 2;
+  }
+  if (use_uring && !beacon_dir.empty()) {
+    std::fprintf(stderr, "vsrvd: beacons require the epoll backend\n");
+    return 2;
+  }
+
+  // Warm start: if a predecessor is listening on the handoff socket, take
+  // its listener fds over SCM_RIGHTS.  This happens after the store is
+  // mapped and the cache built, so the first request after takeover hits a
+  // fully prebuilt response; the predecessor accepts right up to the moment
+  // the fds transfer, so no connection is ever dropped.  A fresh start
+  // (nothing to take over) binds its own listeners.
+  std::vector<int> listener_fds;
+  bool took_over = false;
+  if (!handoff_path.empty() && !use_uring) {
+    listener_fds = vsite::handoff_receive(handoff_path);
+    took_over = !listener_fds.empty();
+    if (took_over && static_cast<int>(listener_fds.size()) != shards) {
+      // The shard count rides with the fds: one listener per shard.
+      shards = static_cast<int>(listener_fds.size());
+    }
+  }
+  if (!use_uring && listener_fds.empty()) {
+    for (int i = 0; i < shards; i++) {
+      listener_fds.push_back(vsite::make_listener(port));
+    }
+  }
+  if (took_over) {
+    std::fprintf(stderr, "vsrvd: took over %d listener%s from predecessor\n",
+                 shards, shards == 1 ? "" : "s");
+  }
+
+  vsite::AccessLog access_log;
+  if (!log_path.empty()) access_log.open(log_path, shards, store);
+
+  vsite::BeaconLog beacons;
+  if (!beacon_dir.empty()) beacons.open(beacon_dir, shards, store);
+
+  vsite::Stats stats(shards);
+  if (admin_port != 0) {
+    stats.serve_admin(admin_port, &store, tls.enabled() ? &tls : nullptr);
+  }
+
+  std::fprintf(stderr, "vsrvd: serving %s%s on port %u, %d %s shard%s\n",
+               pack.empty() ? roots[0].c_str() : pack.c_str(),
+               sites.size() > 1 ? " (+ sites)" : "", port, shards,
+               use_uring ? "uring" : "epoll", shards == 1 ? "" : "s");
+
+  if (use_uring) {
+    std::vector<std::unique_ptr<vsite::UringLoop>> loops;
+    for (int i = 0; i < shards; i++) {
+      loops.push_back(
+          std::make_unique<vsite::UringLoop>(i, port, &store, &cache));
+    }
+    std::vector<std::thread> threads;
+    for (int i = 1; i < shards; i++) {
+      threads.emplace_back([&loops, i] { loops[i]->run(); });
+    }
+    loops[0]->run();
+    return 0;
+  }
+
+  // Loops are constructed up front so every listener exists before traffic
+  // lands, then each shard runs on its own pinned thread.  Loop 0 runs on
+  // the main thread and owns the inotify watch.
+  std::vector<std::unique_ptr<vsite::EventLoop>> loops;
+  for (int i = 0; i < shards; i++) {
+    loops.push_back(std::make_unique<vsite::EventLoop>(
+        i, port, &store, &cache, tls.enabled() ? &tls : nullptr,
+        &stats.shard(i), log_path.empty() ? nullptr : access_log.ring(i),
+        listener_fds[i], search.loaded() ? &search : nullptr, routed,
+        beacon_dir.empty() ? nullptr : beacons.ring(i)));
+    if (rate_limit > 0) {
+      loops.back()->set_rate_limit(static_cast<uint32_t>(rate_limit));
+    }
+  }
+
+  // With a handoff socket configured, wait (on a spare thread) for the next
+  // binary to ask for the listeners, then drain.  handoff_serve blocks for
+  // the process's whole serving life.
+  if (!handoff_path.empty()) {
+    std::thread([&loops, &listener_fds, handoff_path] {
+      vsite::handoff_serve(handoff_path, listener_fds);
+      for (auto& loop : loops) loop->begin_drain();
+    }).detach();
+  }
+
+  std::vector<std::thread> threads;
+  for (int i = 1; i < shards; i++) {
+    threads.emplace_back([&loops, i] { loops[i]->run(); });
+  }
+  loops[0]->run();
+  // run() only returns on drain: the successor owns the listeners and the
+  // last of our connections has closed.
+  for (auto& t : threads) t.join();
+  std::fprintf(stderr, "vsrvd: drained, exiting\n");
+  return 0;
+}
@@ -0,0 +1,62 @@
+#include "srv/site_set.h"
+
+#include <fstream>
+
+namespace vsite {
+
+namespace {
+
+// Lowercase into a stack buffer; hosts are ASCII by the time they reach us
+// (IDNs arrive punycoded).  Returns the usable view.
+std::string_view lower_host(std::string_view host, char* buf, size_t cap) {
+  size_t n = 0;
+  for (char ch : host) {
+    if (ch == ':') break;  // strip the port
+    if (n == cap) break;
+    buf[n++] = (ch >= 'A' && ch <= 'Z') ? static_cast<char>(ch + 32) : ch;
+  }
+  return {buf, n};
+}
+
+}  // namespace
+
+void SiteSet::add(const std::string& root, const std::string& pack) {
+  auto s = std::make_unique<Site>();
+  s->root = root;
+  if (!pack.empty()) {
+    s->store.load_pack(pack);
+  } else {
+    s->store.load(root);
+    s->search.load(root + "/.searchidx");
+  }
+  s->cache.build_all(s->store);
+
+  // CNAME is how the static-host deploy names the site; reuse it verbatim.
+  // Extra lines mean extra aliases.  No file means Host never matches, so
+  // the site is reachable only as the fallback (position zero).
+  std::ifstream f(root + "/CNAME");
+  std::string line;
+  while (std::getline(f, line)) {
+    char buf[128];
+    std::string_view h = lower_host(line, buf, sizeof(buf));
+    if (!h.empty()) s->hosts.emplace_back(h);
+  }
+  sites_.push_back(std::move(s));
+}
+
+Site& SiteSet::find(std::string_view host) {
+  char buf[128];
+  std::string_view h = lower_host(host, buf, sizeof(buf));
+  // The apex and its www alias are the same site; deploys only list the
+  // apex in CNAME.
+  std::string_view bare =
+      h.substr(0, 4) == "www." ? h.substr(4) : std::string_view();
+  for (auto& s : sites_) {
+    for (const std::string& name : s->hosts) {
+      if (name == h || (!bare.empty() && name == bare)) return *s;
+    }
+  }
+  return *sites_[0];
+}
+
+}  // namespace vsite
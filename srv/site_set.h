@@ -0,0 +1,58 @@
+// Multi-site hosting: several site roots behind one listener set, routed by
+// the Host header.
+//
+// Each site is the full single-site shape -- its own AssetStore, prebuilt
+// ResponseCache and optional search index -- seeded from its own root
+// directory.  Serving names come from the root's CNAME file (one host per
+// line, the same file the static-host deploy already carries), so pointing
+// vsrvd at N checkouts needs no extra configuration.  Unknown or absent
+// Host values land on the first site, which keeps curl-by-IP working.
+//
+// Identical bytes across sites -- the shared-stylesheet case -- deduplicate
+// underneath: stores intern mappings by content and caches intern wire
+// responses, so memory grows with unique bytes, not with the tenant count.
+// Per-asset stats and access-log records are slot-indexed and therefore
+// aggregate across sites sharing a slot number.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "srv/asset_store.h"
+#include "srv/response_cache.h"
+#include "srv/search_index.h"
+
+namespace vsite {
+
+struct Site {
+  std::string root;
+  std::vector<std::string> hosts;  // from CNAME, lowercased, no port
+  AssetStore store;
+  ResponseCache cache;
+  SearchIndex search;
+};
+
+class SiteSet {
+ public:
+  // Loads a site from a root directory (or a packed image when pack is
+  // non-empty) and builds its cache.  Fatal on failure, like the underlying
+  // store loads: a configured site that cannot serve is a deploy bug.
+  void add(const std::string& root, const std::string& pack = "");
+
+  // The site for a request's Host header value (port stripped, matched
+  // case-insensitively, with and without a "www." prefix).  Never null:
+  // misses fall through to the first site.
+  Site& find(std::string_view host);
+
+  Site& site(size_t i) { return *sites_[i]; }
+  size_t size() const { return sites_.size(); }
+
+ private:
+  // Sites never move: the loops hold pointers into them for the lifetime of
+  // the process, the same stability contract AssetStore::assets() has.
+  std::vector<std::unique_ptr<Site>> sites_;
+};
+
+}  // namespace vsite
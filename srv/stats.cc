@@ -0,0 +1,160 @@
+#include "srv/stats.h"
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "srv/tls.h"
+
+namespace vsite {
+
+uint64_t monotonic_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+namespace {
+
+// Quantile over buckets merged across shards.
+uint64_t merged_percentile(Stats& self, int shards, double p,
+                           const LatencyHistogram ShardStats::*hist) {
+  uint64_t total = 0;
+  for (int s = 0; s < shards; s++) {
+    total += (self.shard(s).*hist).count();
+  }
+  if (total == 0) return 0;
+  uint64_t rank = static_cast<uint64_t>(p * total);
+  uint64_t seen = 0;
+  for (int i = 0; i < LatencyHistogram::kBuckets; i++) {
+    for (int s = 0; s < shards; s++) {
+      seen += (self.shard(s).*hist).bucket(i);
+    }
+    if (seen >= rank && seen > 0) return LatencyHistogram::value_of(i);
+  }
+  return 0;
+}
+
+}  // namespace
+
+std::string Stats::render(const AssetStore& store,
+                          const TlsContext* tls) const {
+  auto* self = const_cast<Stats*>(this);
+  std::string out;
+  out.reserve(4096);
+  char line[256];
+
+  const auto& assets = const_cast<AssetStore&>(store).assets();
+  out += "# TYPE vsrvd_requests_total counter\n";
+  for (size_t i = 0; i < assets.size() && i < kStatsMaxAssets; i++) {
+    uint64_t hits = 0;
+    for (int s = 0; s < shards_; s++) {
+      hits += self->shard(s).asset_hits[i].load(std::memory_order_relaxed);
+    }
+    std::snprintf(line, sizeof(line),
+                  "vsrvd_requests_total{asset=\"%s\"} %llu\n",
+                  assets[i].url_path.c_str(),
+                  static_cast<unsigned long long>(hits));
+    out += line;
+  }
+  uint64_t nf = 0, conns = 0, rejected = 0;
+  for (int s = 0; s < shards_; s++) {
+    nf += self->shard(s).not_found.load(std::memory_order_relaxed);
+    conns += self->shard(s).connections.load(std::memory_order_relaxed);
+    rejected += self->shard(s).rejected.load(std::memory_order_relaxed);
+  }
+  std::snprintf(line, sizeof(line),
+                "vsrvd_requests_total{asset=\"404\"} %llu\n"
+                "# TYPE vsrvd_connections_total counter\n"
+                "vsrvd_connections_total %llu\n"
+                "# TYPE vsrvd_rejected_total counter\n"
+                "vsrvd_rejected_total %llu\n",
+                static_cast<unsigned long long>(nf),
+                static_cast<unsigned long long>(conns),
+                static_cast<unsigned long long>(rejected));
+  out += line;
+
+  struct {
+    const char* name;
+    const LatencyHistogram ShardStats::*hist;
+  } metrics[] = {{"vsrvd_ttfb_us", &ShardStats::ttfb},
+                 {"vsrvd_response_us", &ShardStats::response}};
+  for (const auto& m : metrics) {
+    uint64_t count = 0, sum = 0;
+    for (int s = 0; s < shards_; s++) {
+      count += (self->shard(s).*m.hist).count();
+      sum += (self->shard(s).*m.hist).sum_us();
+    }
+    std::snprintf(line, sizeof(line), "# TYPE %s summary\n", m.name);
+    out += line;
+    for (double q : {0.5, 0.99, 0.999}) {
+      uint64_t v = merged_percentile(*self, shards_, q, m.hist);
+      std::snprintf(line, sizeof(line), "%s{quantile=\"%g\"} %llu\n",
+                    m.name, q, static_cast<unsigned long long>(v));
+      out += line;
+    }
+    std::snprintf(line, sizeof(line),
+                  "%s_sum %llu\n%s_count %llu\n", m.name,
+                  static_cast<unsigned long long>(sum), m.name,
+                  static_cast<unsigned long long>(count));
+    out += line;
+  }
+
+  if (tls != nullptr && tls->enabled()) {
+    std::snprintf(line, sizeof(line),
+                  "# TYPE vsrvd_tls_handshakes_total counter\n"
+                  "vsrvd_tls_handshakes_total{kind=\"full\"} %llu\n"
+                  "vsrvd_tls_handshakes_total{kind=\"resumed\"} %llu\n",
+                  static_cast<unsigned long long>(tls->full_handshakes()),
+                  static_cast<unsigned long long>(tls->resumed_handshakes()));
+    out += line;
+  }
+  return out;
+}
+
+void Stats::serve_admin(uint16_t port, const AssetStore* store,
+                        const TlsContext* tls) {
+  std::thread([this, port, store, tls] {
+    int lfd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (lfd < 0) return;
+    int one = 1;
+    setsockopt(lfd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (bind(lfd, reinterpret_cast<struct sockaddr*>(&addr),
+             sizeof(addr)) < 0 ||
+        listen(lfd, 16) < 0) {
+      std::fprintf(stderr, "stats: cannot listen on admin port %u\n", port);
+      close(lfd);
+      return;
+    }
+    // Scrapes are rare and tiny; plain blocking accept is the right tool
+    // and keeps this thread entirely off the serving loops.
+    for (;;) {
+      int fd = accept(lfd, nullptr, nullptr);
+      if (fd < 0) continue;
+      char buf[1024];
+      (void)!read(fd, buf, sizeof(buf));
+      std::string body = render(*store, tls);
+      char hdr[160];
+      int n = std::snprintf(hdr, sizeof(hdr),
+                            "HTTP/1.1 200 OK\r\n"
+                            "Content-Type: text/plain; version=0.0.4\r\n"
+                            "Content-Length: %zu\r\n"
+                            "Connection: close\r\n\r\n",
+                            body.size());
+      (void)!write(fd, hdr, n);
+      (void)!write(fd, body.data(), body.size());
+      close(fd);
+    }
+  }).detach();
+}
+
+}  // namespace vsite
@@ -0,0 +1,106 @@
+// Hot-path instrumentation: per-shard lock-free histograms and counters.
+//
+// Each event loop owns one ShardStats (cache-line padded, written only by
+// its core); recording a sample is an index computation and a relaxed
+// atomic add -- a handful of nanoseconds, no locks, no allocation, safe to
+// leave on in production.  Aggregation happens only when the admin endpoint
+// is scraped: the admin thread sums across shards with relaxed loads and
+// renders Prometheus text.
+//
+// Tracked per request: accept-to-first-byte, full response time, and hit
+// counts per asset (index.html, style.css, the PDF) plus 404s.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "srv/asset_store.h"
+
+namespace vsite {
+
+class TlsContext;
+
+// Log-linear latency histogram in microseconds: exact to 1 ms, then 64
+// buckets per octave (~1.5% max error at the tail).  Single writer per
+// instance; readers merge with relaxed loads.
+class LatencyHistogram {
+ public:
+  static constexpr int kBuckets = 2048;
+
+  void record(uint64_t us) {
+    buckets_[index_of(us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_us_.fetch_add(us, std::memory_order_relaxed);
+  }
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t sum_us() const { return sum_us_.load(std::memory_order_relaxed); }
+  uint64_t bucket(int i) const {
+    return buckets_[i].load(std::memory_order_relaxed);
+  }
+
+  static int index_of(uint64_t us) {
+    if (us < 1024) return static_cast<int>(us);
+    int msb = 63 - __builtin_clzll(us);
+    int idx = 1024 + (msb - 10) * 64 +
+              static_cast<int>((us >> (msb - 6)) & 63);
+    return idx < kBuckets ? idx : kBuckets - 1;
+  }
+  static uint64_t value_of(int idx) {
+    if (idx < 1024) return idx;
+    int msb = (idx - 1024) / 64 + 10;
+    uint64_t frac = (idx - 1024) % 64;
+    return (1ull << msb) | (frac << (msb - 6));
+  }
+
+ private:
+  std::atomic<uint64_t> buckets_[kBuckets] = {};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_us_{0};
+};
+
+constexpr int kStatsMaxAssets = 64;
+
+struct alignas(64) ShardStats {
+  LatencyHistogram ttfb;      // accept (or request arrival) to first byte
+  LatencyHistogram response;  // request arrival to last byte
+  std::atomic<uint64_t> asset_hits[kStatsMaxAssets] = {};
+  std::atomic<uint64_t> not_found{0};
+  std::atomic<uint64_t> connections{0};
+  std::atomic<uint64_t> rejected{0};  // admission-control refusals
+
+  void count_hit(int asset_idx) {
+    if (asset_idx < 0) {
+      not_found.fetch_add(1, std::memory_order_relaxed);
+    } else if (asset_idx < kStatsMaxAssets) {
+      asset_hits[asset_idx].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+};
+
+class Stats {
+ public:
+  static constexpr int kMaxShards = 64;
+
+  explicit Stats(int shards) : shards_(shards < kMaxShards ? shards
+                                                           : kMaxShards) {}
+
+  ShardStats& shard(int i) { return per_shard_[i % kMaxShards]; }
+
+  // Prometheus text exposition, aggregated across shards on demand.
+  std::string render(const AssetStore& store, const TlsContext* tls) const;
+
+  // Serves render() on a dedicated port from its own thread; never touches
+  // the serving loops.
+  void serve_admin(uint16_t port, const AssetStore* store,
+                   const TlsContext* tls);
+
+ private:
+  int shards_;
+  ShardStats per_shard_[kMaxShards];
+};
+
+uint64_t monotonic_ns();
+
+}  // namespace vsite
@@ -0,0 +1,53 @@
+// Runtime support for build-time compiled HTML templates.
+//
+// tools/tplc turns a page like index.html into a generated render function
+// (see the gen/ outputs) whose static text lives in the binary as string
+// literals.  TemplateVars is the only runtime piece: a fixed-capacity
+// name/value table the caller fills before rendering.  Rendering writes into
+// a caller-provided buffer and never allocates; when no variables are set
+// the generated code memcpys the original page bytes in one shot, so the
+// fast path is byte-identical to the hand-written file.
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace vsite {
+
+class TemplateVars {
+ public:
+  static constexpr int kMaxVars = 16;
+
+  // Sets or overwrites a variable.  Silently drops past capacity: variant
+  // pages have a handful of slots, not dozens.
+  void set(std::string_view name, std::string_view value) {
+    for (int i = 0; i < n_; i++) {
+      if (names_[i] == name) {
+        values_[i] = value;
+        return;
+      }
+    }
+    if (n_ < kMaxVars) {
+      names_[n_] = name;
+      values_[n_] = value;
+      n_++;
+    }
+  }
+
+  // Value for a name, or "" when unset (unset slots render as nothing).
+  std::string_view get(std::string_view name) const {
+    for (int i = 0; i < n_; i++) {
+      if (names_[i] == name) return values_[i];
+    }
+    return {};
+  }
+
+  bool empty() const { return n_ == 0; }
+
+ private:
+  std::string_view names_[kMaxVars];
+  std::string_view values_[kMaxVars];
+  int n_ = 0;
+};
+
+}  // namespace vsite
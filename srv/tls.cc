@@ -0,0 +1,123 @@
+#include "srv/tls.h"
+
+#include <openssl/core_names.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/params.h>
+#include <openssl/rand.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace vsite {
+
+namespace {
+
+[[noreturn]] void die_ssl(const char* what) {
+  std::fprintf(stderr, "fatal: %s:\n", what);
+  ERR_print_errors_fp(stderr);
+  std::exit(1);
+}
+
+// The ticket callback gets no user pointer; there is exactly one TlsContext
+// per process, so a file-local backpointer is the whole registry.
+TlsContext* g_tls = nullptr;
+
+}  // namespace
+
+void TlsContext::init(const std::string& cert_path,
+                      const std::string& key_path) {
+  ctx_ = SSL_CTX_new(TLS_server_method());
+  if (ctx_ == nullptr) die_ssl("SSL_CTX_new");
+  SSL_CTX_set_min_proto_version(ctx_, TLS1_2_VERSION);
+  if (SSL_CTX_use_certificate_chain_file(ctx_, cert_path.c_str()) != 1)
+    die_ssl(cert_path.c_str());
+  if (SSL_CTX_use_PrivateKey_file(ctx_, key_path.c_str(),
+                                  SSL_FILETYPE_PEM) != 1)
+    die_ssl(key_path.c_str());
+
+#ifdef SSL_OP_ENABLE_KTLS
+  // With a kernel-supported cipher the record layer moves below the socket:
+  // SSL_write of a prebuilt response buffer is then as cheap as write, and
+  // no bytes are re-encrypted in userspace.
+  SSL_CTX_set_options(ctx_, SSL_OP_ENABLE_KTLS);
+#endif
+
+  // Stateless resumption only: tickets need no server-side session store,
+  // so resumption scales across shards with zero shared mutable state
+  // beyond the ticket key below.
+  SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_OFF);
+  SSL_CTX_set_num_tickets(ctx_, 2);
+
+  if (RAND_bytes(reinterpret_cast<unsigned char*>(&keys_[0]),
+                 sizeof(TicketKey)) != 1)
+    die_ssl("RAND_bytes");
+  keys_[1] = keys_[0];
+  keys_[2] = keys_[0];
+  g_tls = this;
+  SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx_, ticket_key_cb);
+}
+
+void TlsContext::rotate_ticket_key() {
+  // The slot being filled is the one retired a whole rotation period ago:
+  // decrypt only probes current and previous, so by the time a generation
+  // comes back around for reuse no handshake thread can still be reading
+  // it, and the fill never races a reader.
+  int cur = current_.load(std::memory_order_relaxed);
+  int next = (cur + 1) % 3;
+  if (RAND_bytes(reinterpret_cast<unsigned char*>(&keys_[next]),
+                 sizeof(TicketKey)) != 1)
+    return;  // keep encrypting under the old key rather than dying
+  current_.store(next, std::memory_order_release);
+}
+
+SSL* TlsContext::new_session(int fd) {
+  SSL* ssl = SSL_new(ctx_);
+  if (ssl == nullptr) return nullptr;
+  SSL_set_fd(ssl, fd);
+  SSL_set_accept_state(ssl);
+  return ssl;
+}
+
+int TlsContext::ticket_key_cb(SSL* /*ssl*/, unsigned char* key_name,
+                              unsigned char* iv, EVP_CIPHER_CTX* cipher,
+                              EVP_MAC_CTX* mac, int enc) {
+  TlsContext* t = g_tls;
+  if (t == nullptr) return -1;
+
+  auto setup = [&](const TicketKey& k, const unsigned char* use_iv,
+                   int mode) {
+    OSSL_PARAM params[3];
+    params[0] = OSSL_PARAM_construct_octet_string(
+        OSSL_MAC_PARAM_KEY, const_cast<uint8_t*>(k.hmac), sizeof(k.hmac));
+    params[1] = OSSL_PARAM_construct_utf8_string(
+        OSSL_MAC_PARAM_DIGEST, const_cast<char*>("sha256"), 0);
+    params[2] = OSSL_PARAM_construct_end();
+    if (EVP_MAC_CTX_set_params(mac, params) != 1) return false;
+    return EVP_CipherInit_ex(cipher, EVP_aes_256_cbc(), nullptr, k.aes,
+                             use_iv, mode) == 1;
+  };
+
+  if (enc) {
+    int cur = t->current_.load(std::memory_order_acquire);
+    const TicketKey& k = t->keys_[cur];
+    if (RAND_bytes(iv, EVP_MAX_IV_LENGTH) != 1) return -1;
+    std::memcpy(key_name, k.name, sizeof(k.name));
+    return setup(k, iv, /*encrypt=*/1) ? 1 : -1;
+  }
+
+  int cur = t->current_.load(std::memory_order_acquire);
+  for (int gen : {cur, (cur + 2) % 3}) {
+    const TicketKey& k = t->keys_[gen];
+    if (std::memcmp(key_name, k.name, sizeof(k.name)) == 0) {
+      if (!setup(k, iv, /*encrypt=*/0)) return -1;
+      // A ticket under the retiring key still resumes, but the client gets
+      // a fresh ticket so the old key can age out.
+      return gen == cur ? 1 : 2;
+    }
+  }
+  return 0;  // unknown key: fall back to a full handshake
+}
+
+}  // namespace vsite
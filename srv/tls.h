@@ -0,0 +1,71 @@
+// TLS for the serving core: session resumption and kernel offload.
+//
+// One TlsContext is shared by every event loop.  Resumption is stateless
+// (session tickets), so there is no per-session server cache to lock; the
+// shared state is just the ticket key, held in a three-slot rotating
+// array behind an atomic index so key rollover never blocks a handshake on
+// any core.  kTLS is requested via SSL_OP_ENABLE_KTLS -- once a handshake
+// negotiates a kernel-supported cipher, record encryption happens below the
+// socket and SSL_write of prebuilt response buffers costs the same as plain
+// write.
+//
+// Full vs resumed handshake counts are kept here; the target is >80%
+// resumed on return-visitor traffic.
+#pragma once
+
+#include <openssl/ssl.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace vsite {
+
+class TlsContext {
+ public:
+  // Loads the PEM cert chain and key.  Fatal on failure -- a TLS listener
+  // with no credentials has no job.  Generates the first ticket key.
+  void init(const std::string& cert_path, const std::string& key_path);
+
+  // Rotates the ticket key: new sessions encrypt under the fresh key while
+  // tickets under the previous one still decrypt (and re-issue).  Call
+  // roughly hourly from any one loop; readers never block.
+  void rotate_ticket_key();
+
+  SSL* new_session(int fd);
+
+  void count_handshake(bool resumed) {
+    (resumed ? resumed_ : full_).fetch_add(1, std::memory_order_relaxed);
+  }
+  uint64_t full_handshakes() const {
+    return full_.load(std::memory_order_relaxed);
+  }
+  uint64_t resumed_handshakes() const {
+    return resumed_.load(std::memory_order_relaxed);
+  }
+
+  bool enabled() const { return ctx_ != nullptr; }
+
+ private:
+  struct TicketKey {
+    uint8_t name[16];
+    uint8_t aes[32];
+    uint8_t hmac[32];
+  };
+
+  static int ticket_key_cb(SSL* ssl, unsigned char* key_name,
+                           unsigned char* iv, EVP_CIPHER_CTX* cipher,
+                           EVP_MAC_CTX* mac, int enc);
+
+  SSL_CTX* ctx_ = nullptr;
+  // keys_[current_] encrypts and the previous slot still decrypts; the
+  // third slot is the generation retired before that, which no handshake
+  // thread probes any more, so rotation can fill it without ever writing
+  // bytes a concurrent reader may touch.
+  TicketKey keys_[3];
+  std::atomic<int> current_{0};
+  std::atomic<uint64_t> full_{0};
+  std::atomic<uint64_t> resumed_{0};
+};
+
+}  // namespace vsite
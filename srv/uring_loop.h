@@ -0,0 +1,41 @@
+// io_uring backend for the serving loop, selectable with "-b uring".
+//
+// Same sharding model as EventLoop (one loop per core, SO_REUSEPORT), but
+// readiness polling and per-request syscalls are replaced by batched
+// submissions: multishot accept keeps the listener armed without
+// resubmission, recv and send SQEs for every connection touched in an
+// iteration go to the kernel in a single io_uring_submit, and responses are
+// sent from the prebuilt cache buffers.  At high connection counts this
+// trades dozens of syscall entries per iteration for one.
+//
+// Built only where liburing is present (HAVE_LIBURING, detected by the
+// Makefile); otherwise available() is false and startup falls back to the
+// epoll backend with a notice.  TLS terminates on the epoll backend only
+// for now.
+#pragma once
+
+#include <cstdint>
+
+#include "srv/asset_store.h"
+#include "srv/response_cache.h"
+
+namespace vsite {
+
+class UringLoop {
+ public:
+  // True when this binary carries the io_uring backend.
+  static bool available();
+
+  UringLoop(int index, uint16_t port, AssetStore* store,
+            ResponseCache* cache);
+  ~UringLoop();
+
+  // Runs forever.  Call from the thread that should own this shard.
+  void run();
+
+ private:
+  struct Impl;
+  Impl* impl_ = nullptr;
+};
+
+}  // namespace vsite
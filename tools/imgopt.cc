@@ -0,0 +1,362 @@
+// imgopt: parallel image optimization stage for the build pipeline.
+//
+// Scans a source directory for raster images and emits, per image:
+//   - the original with metadata stripped (EXIF/ICC/comments parsed out of
+//     the JPEG marker stream or PNG chunk list natively, no decode);
+//   - WebP and AVIF variants at each requested width, when the cwebp and
+//     avifenc encoders are on PATH (missing encoders skip their formats --
+//     the stage degrades to metadata stripping, never fails the build);
+//   - an .srcset manifest ("stem width file" per line) the page generator
+//     can turn into <img srcset=...> attributes.
+//
+// Every output is keyed by its input's content hash in out_dir/.imgopt.state,
+// so unchanged images are never reprocessed -- a warm run over a large
+// gallery touches nothing.  Work is spread over a pool of threads with
+// per-worker deques and work stealing: encodes vary wildly in cost (a big
+// JPEG at three widths vs a tiny icon), and stealing keeps all cores busy
+// until the last encode finishes.
+//
+//   usage: imgopt [-s src_dir] [-o out_dir] [-j threads] [-w w1,w2,...]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+uint64_t fnv1a64_file(const fs::path& p) {
+  std::ifstream f(p, std::ios::binary);
+  if (!f) return 0;
+  uint64_t h = 0xcbf29ce484222325ull;
+  char buf[65536];
+  while (f.read(buf, sizeof(buf)) || f.gcount() > 0) {
+    for (std::streamsize i = 0; i < f.gcount(); i++) {
+      h ^= static_cast<uint8_t>(buf[i]);
+      h *= 0x100000001b3ull;
+    }
+  }
+  return h;
+}
+
+std::string read_file(const fs::path& p) {
+  std::ifstream f(p, std::ios::binary);
+  std::ostringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+bool write_file(const fs::path& p, const std::string& bytes) {
+  std::ofstream f(p, std::ios::binary | std::ios::trunc);
+  return f && f.write(bytes.data(), bytes.size()).good();
+}
+
+// Drops JPEG metadata segments without touching image data: EXIF and XMP
+// (APP1), ICC (APP2) through APP13, and comments.  APP0 (JFIF) and APP14
+// (Adobe color transform) stay -- removing those can shift colors.
+std::string strip_jpeg(const std::string& in) {
+  if (in.size() < 4 || static_cast<uint8_t>(in[0]) != 0xff ||
+      static_cast<uint8_t>(in[1]) != 0xd8) {
+    return in;
+  }
+  std::string out;
+  out.reserve(in.size());
+  out.append(in, 0, 2);
+  size_t pos = 2;
+  while (pos + 4 <= in.size()) {
+    if (static_cast<uint8_t>(in[pos]) != 0xff) break;  // malformed; bail
+    uint8_t marker = static_cast<uint8_t>(in[pos + 1]);
+    if (marker == 0xda) {
+      // Start of scan: entropy-coded data runs to EOI, copy verbatim.
+      out.append(in, pos, std::string::npos);
+      return out;
+    }
+    size_t seg = 2 + ((static_cast<uint8_t>(in[pos + 2]) << 8) |
+                      static_cast<uint8_t>(in[pos + 3]));
+    bool drop = (marker >= 0xe1 && marker <= 0xed) ||  // APP1..APP13
+                marker == 0xfe;                        // COM
+    if (!drop) out.append(in, pos, seg);
+    pos += seg;
+  }
+  return in;  // parse ran off the rails; keep the original bytes
+}
+
+// Drops PNG ancillary metadata chunks (text, time, EXIF); critical chunks
+// and everything that affects rendering pass through.
+std::string strip_png(const std::string& in) {
+  static const char kSig[8] = {'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a',
+                               '\n'};
+  if (in.size() < 8 || std::memcmp(in.data(), kSig, 8) != 0) return in;
+  std::string out(in, 0, 8);
+  size_t pos = 8;
+  while (pos + 12 <= in.size()) {
+    uint32_t len = (static_cast<uint8_t>(in[pos]) << 24) |
+                   (static_cast<uint8_t>(in[pos + 1]) << 16) |
+                   (static_cast<uint8_t>(in[pos + 2]) << 8) |
+                   static_cast<uint8_t>(in[pos + 3]);
+    std::string type = in.substr(pos + 4, 4);
+    size_t chunk = 12 + len;
+    if (pos + chunk > in.size()) return in;
+    bool drop = type == "tEXt" || type == "zTXt" || type == "iTXt" ||
+                type == "eXIf" || type == "tIME";
+    if (!drop) out.append(in, pos, chunk);
+    pos += chunk;
+    if (type == "IEND") break;
+  }
+  return out;
+}
+
+bool have_cmd(const char* name) {
+  std::string probe = std::string("command -v ") + name + " >/dev/null 2>&1";
+  return std::system(probe.c_str()) == 0;
+}
+
+struct Job {
+  fs::path src;
+  uint64_t hash = 0;
+};
+
+// Per-worker deque with stealing: a worker pops its own back, and when dry
+// steals from another's front.  Encode times are lopsided, so the fast
+// workers drain the slow ones' queues instead of idling.
+struct WorkerQueue {
+  std::deque<Job> q;
+  std::mutex m;
+};
+
+struct Pool {
+  std::vector<WorkerQueue> queues;
+  std::atomic<int> pending{0};
+
+  explicit Pool(int n) : queues(n) {}
+
+  bool pop(int self, Job* out) {
+    {
+      std::lock_guard<std::mutex> lk(queues[self].m);
+      if (!queues[self].q.empty()) {
+        *out = std::move(queues[self].q.back());
+        queues[self].q.pop_back();
+        return true;
+      }
+    }
+    for (size_t i = 1; i < queues.size(); i++) {
+      WorkerQueue& v = queues[(self + i) % queues.size()];
+      std::lock_guard<std::mutex> lk(v.m);
+      if (!v.q.empty()) {
+        *out = std::move(v.q.front());
+        v.q.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+};
+
+using State = std::map<std::string, uint64_t>;
+
+State load_state(const fs::path& path) {
+  State s;
+  std::ifstream f(path);
+  std::string name;
+  uint64_t hash;
+  while (f >> name >> std::hex >> hash) s[name] = hash;
+  return s;
+}
+
+void save_state(const fs::path& path, const State& s) {
+  std::ofstream f(path, std::ios::trunc);
+  for (const auto& [name, hash] : s) {
+    f << name << " " << std::hex << hash << "\n";
+  }
+}
+
+uint64_t now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  fs::path src_dir = "photos";
+  fs::path out_dir = "dist/photos";
+  int threads = static_cast<int>(std::thread::hardware_concurrency());
+  std::vector<int> widths = {480, 960, 1920};
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "-s") && i + 1 < argc) src_dir = argv[++i];
+    else if (!std::strcmp(argv[i], "-o") && i + 1 < argc) out_dir = argv[++i];
+    else if (!std::strcmp(argv[i], "-j") && i + 1 < argc)
+      threads = std::atoi(argv[++i]);
+    else if (!std::strcmp(argv[i], "-w") && i + 1 < argc) {
+      widths.clear();
+      for (char* tok = std::strtok(argv[++i], ","); tok != nullptr;
+           tok = std::strtok(nullptr, ",")) {
+        widths.push_back(std::atoi(tok));
+      }
+    } else {
+      std::fprintf(stderr,
+                   "usage: %s [-s src_dir] [-o out_dir] [-j threads] "
+                   "[-w w1,w2,...]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+  if (threads < 1) threads = 1;
+  if (!fs::is_directory(src_dir)) {
+    std::fprintf(stderr, "imgopt: no %s directory, nothing to do\n",
+                 src_dir.c_str());
+    return 0;
+  }
+  uint64_t t0 = now_ms();
+
+  const bool webp = have_cmd("cwebp");
+  const bool avif_enc = have_cmd("avifenc");
+  if (!webp || !avif_enc) {
+    std::fprintf(stderr, "imgopt: %s%s%s not on PATH; those formats are "
+                 "skipped this build\n",
+                 webp ? "" : "cwebp", (!webp && !avif_enc) ? " and " : "",
+                 avif_enc ? "" : "avifenc");
+  }
+  // avifenc cannot scale, so per-width AVIFs go through a resized PNG
+  // intermediate from ImageMagick.  Without a resizer the AVIF tier is
+  // skipped outright -- a full-resolution image labelled "480w" in the
+  // srcset would make browsers download more, not less.
+  const bool magick = have_cmd("magick");
+  const bool resizer = magick || have_cmd("convert");
+  const bool avif = avif_enc && resizer;
+  if (avif_enc && !resizer) {
+    std::fprintf(stderr, "imgopt: no magick/convert to scale for avifenc; "
+                 "AVIF variants are skipped this build\n");
+  }
+  const char* resize_cmd = magick ? "magick" : "convert";
+
+  fs::create_directories(out_dir);
+  fs::path state_path = out_dir / ".imgopt.state";
+  State prev = load_state(state_path);
+  State next;
+  std::mutex state_mu;  // guards next and the counters below
+  int rebuilt = 0, reused = 0, failed = 0;
+
+  // Enumerate images and deal them round-robin across worker queues.
+  Pool pool(threads);
+  int dealt = 0;
+  for (const auto& ent : fs::directory_iterator(src_dir)) {
+    if (!ent.is_regular_file()) continue;
+    std::string ext = ent.path().extension().string();
+    if (ext != ".jpg" && ext != ".jpeg" && ext != ".png") continue;
+    Job j;
+    j.src = ent.path();
+    j.hash = fnv1a64_file(j.src);
+    pool.queues[dealt++ % threads].q.push_back(std::move(j));
+  }
+
+  auto work = [&](int self) {
+    Job j;
+    while (pool.pop(self, &j)) {
+      std::string name = j.src.filename().string();
+      std::string stem = j.src.stem().string();
+      std::string ext = j.src.extension().string();
+
+      // Every variant this image produces, checked against the state file
+      // as a unit: name -> (out_name, shell command or "" for native strip).
+      std::vector<std::pair<std::string, std::string>> variants;
+      variants.emplace_back(name, "");
+      for (int w : widths) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%s.%dw.webp", stem.c_str(), w);
+        if (webp) {
+          variants.emplace_back(
+              buf, "cwebp -quiet -metadata none -resize " +
+                       std::to_string(w) + " 0 '" + j.src.string() +
+                       "' -o '" + (out_dir / buf).string() + "'");
+        }
+        std::snprintf(buf, sizeof(buf), "%s.%dw.avif", stem.c_str(), w);
+        if (avif) {
+          // Scale first, then encode; the intermediate is unique per
+          // output, so parallel workers never collide.  The exit status
+          // is whichever stage failed, captured before the cleanup.
+          std::string tmp = (out_dir / buf).string() + ".tmp.png";
+          variants.emplace_back(
+              buf, std::string(resize_cmd) + " '" + j.src.string() +
+                       "' -resize " + std::to_string(w) + " '" + tmp +
+                       "' >/dev/null 2>&1 && avifenc --speed 8 -q 60 '" +
+                       tmp + "' '" + (out_dir / buf).string() +
+                       "' >/dev/null 2>&1; rc=$?; rm -f '" + tmp +
+                       "'; exit $rc");
+        }
+      }
+
+      for (auto& [out_name, cmd] : variants) {
+        {
+          std::lock_guard<std::mutex> lk(state_mu);
+          next[out_name] = j.hash;
+          auto it = prev.find(out_name);
+          if (it != prev.end() && it->second == j.hash &&
+              fs::exists(out_dir / out_name)) {
+            reused++;
+            continue;
+          }
+        }
+        bool ok;
+        if (cmd.empty()) {
+          std::string bytes = read_file(j.src);
+          std::string stripped =
+              ext == ".png" ? strip_png(bytes) : strip_jpeg(bytes);
+          ok = write_file(out_dir / out_name, stripped);
+        } else {
+          ok = std::system(cmd.c_str()) == 0;
+        }
+        std::lock_guard<std::mutex> lk(state_mu);
+        if (ok) {
+          rebuilt++;
+        } else {
+          failed++;
+          next.erase(out_name);  // retry next run
+        }
+      }
+    }
+  };
+
+  std::vector<std::thread> pool_threads;
+  for (int i = 1; i < threads; i++) pool_threads.emplace_back(work, i);
+  work(0);
+  for (std::thread& t : pool_threads) t.join();
+
+  // srcset manifest: original listed as width 0 (intrinsic size).
+  {
+    std::ofstream sf(out_dir / ".srcset", std::ios::trunc);
+    for (const auto& [out_name, hash] : next) {
+      size_t first_dot = out_name.find('.');
+      std::string stem = out_name.substr(0, first_dot);
+      // Variant names are stem.<width>w.<fmt>; everything else is the
+      // stripped original, listed as width 0 (intrinsic size).
+      int width = 0;
+      if (first_dot != std::string::npos &&
+          out_name.find("w.", first_dot) != std::string::npos) {
+        width = std::atoi(out_name.c_str() + first_dot + 1);
+      }
+      sf << stem << " " << width << " " << out_name << "\n";
+    }
+  }
+
+  save_state(state_path, next);
+  std::fprintf(stderr,
+               "imgopt: %d variants rebuilt, %d up-to-date, %d failed in "
+               "%llu ms (%d threads)\n",
+               rebuilt, reused, failed,
+               static_cast<unsigned long long>(now_ms() - t0), threads);
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,228 @@
+// linkcheck: validates every link in the built site, one extraction pass.
+//
+// Internal targets (relative href/src) are checked against the output tree
+// and any dead one fails the build -- we have shipped broken links twice.
+// External targets are deduplicated and probed with a TCP connect over a
+// bounded pool of nonblocking sockets; unreachable hosts warn but never
+// fail, since release builds run on machines without network.  Probing is
+// off by default (-e enables it) so offline builds stay deterministic.
+//
+// The same pass emits the .preload map (stylesheet links that survived the
+// inliner, "page target" per line) consumed by the server's Early Hints,
+// so link extraction happens once per build, not once per consumer.
+//
+//   usage: linkcheck [-d dist_dir] [-e] [-c max_conns]
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Link {
+  std::string page;
+  std::string target;
+  bool stylesheet = false;
+};
+
+std::string read_file(const fs::path& p) {
+  std::ifstream f(p, std::ios::binary);
+  std::ostringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+// href/src values with their tag context, so stylesheet links can feed the
+// preload map from the same pass.
+void extract_links(const fs::path& page, std::vector<Link>* out) {
+  std::string html = read_file(page);
+  size_t pos = 0;
+  while ((pos = html.find('<', pos)) != std::string::npos) {
+    size_t end = html.find('>', pos);
+    if (end == std::string::npos) break;
+    std::string tag = html.substr(pos, end - pos);
+    pos = end;
+    bool stylesheet = tag.rfind("<link", 0) == 0 &&
+                      tag.find("stylesheet") != std::string::npos;
+    for (const char* attr : {"href=\"", "src=\""}) {
+      size_t a = tag.find(attr);
+      if (a == std::string::npos) continue;
+      a += std::strlen(attr);
+      size_t q = tag.find('"', a);
+      if (q == std::string::npos) continue;
+      std::string ref = tag.substr(a, q - a);
+      if (ref.empty() || ref[0] == '#' || ref.rfind("mailto:", 0) == 0 ||
+          ref.rfind("data:", 0) == 0) {
+        continue;
+      }
+      out->push_back({page.filename().string(), ref, stylesheet});
+    }
+  }
+}
+
+// Strips fragment/query and resolves the target within the output tree.
+bool internal_target_exists(const fs::path& dist, const std::string& ref) {
+  std::string t = ref.substr(0, ref.find_first_of("#?"));
+  if (t.empty()) return true;
+  if (t[0] == '/') t = t.substr(1);
+  if (t.empty() || t.back() == '/') t += "index.html";
+  return fs::exists(dist / t);
+}
+
+struct Probe {
+  std::string host;
+  uint16_t port;
+  int fd = -1;
+  bool ok = false;
+  bool done = false;
+};
+
+// Bounded-concurrency reachability check: nonblocking connect() to the
+// link's host, success meaning the TCP handshake completed.  Full request
+// probing would need a TLS client for next to no extra signal.
+void probe_external(std::vector<Probe>* probes, int max_conns) {
+  size_t next = 0;
+  std::vector<Probe*> active;
+  while (next < probes->size() || !active.empty()) {
+    while (static_cast<int>(active.size()) < max_conns &&
+           next < probes->size()) {
+      Probe* pr = &(*probes)[next++];
+      struct addrinfo hints{};
+      hints.ai_family = AF_INET;
+      hints.ai_socktype = SOCK_STREAM;
+      struct addrinfo* res = nullptr;
+      char port[8];
+      std::snprintf(port, sizeof(port), "%u", pr->port);
+      if (getaddrinfo(pr->host.c_str(), port, &hints, &res) != 0) {
+        pr->done = true;
+        continue;
+      }
+      pr->fd = socket(res->ai_family,
+                      res->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (pr->fd >= 0 &&
+          connect(pr->fd, res->ai_addr, res->ai_addrlen) == 0) {
+        pr->ok = true;
+        pr->done = true;
+        close(pr->fd);
+      } else if (pr->fd >= 0 && errno == EINPROGRESS) {
+        active.push_back(pr);
+      } else {
+        if (pr->fd >= 0) close(pr->fd);
+        pr->done = true;
+      }
+      freeaddrinfo(res);
+    }
+    if (active.empty()) continue;
+
+    std::vector<struct pollfd> pfds;
+    for (Probe* pr : active) pfds.push_back({pr->fd, POLLOUT, 0});
+    int n = poll(pfds.data(), pfds.size(), 3000);
+    for (size_t i = 0; i < active.size();) {
+      bool timed_out = (n == 0);
+      if (pfds[i].revents != 0 || timed_out) {
+        int err = 1;
+        socklen_t len = sizeof(err);
+        if (!timed_out) {
+          getsockopt(active[i]->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        }
+        active[i]->ok = !timed_out && err == 0;
+        active[i]->done = true;
+        close(active[i]->fd);
+        active.erase(active.begin() + i);
+        pfds.erase(pfds.begin() + i);
+      } else {
+        i++;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  fs::path dist = "dist";
+  bool external = false;
+  int max_conns = 8;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "-d") && i + 1 < argc) dist = argv[++i];
+    else if (!std::strcmp(argv[i], "-e")) external = true;
+    else if (!std::strcmp(argv[i], "-c") && i + 1 < argc)
+      max_conns = std::atoi(argv[++i]);
+    else {
+      std::fprintf(stderr, "usage: %s [-d dist_dir] [-e] [-c max_conns]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<Link> links;
+  for (const auto& ent : fs::directory_iterator(dist)) {
+    if (ent.is_regular_file() && ent.path().extension() == ".html") {
+      extract_links(ent.path(), &links);
+    }
+  }
+
+  int dead = 0, checked_internal = 0;
+  std::set<std::pair<std::string, uint16_t>> hosts;
+  std::ofstream preload(dist / ".preload", std::ios::trunc);
+  for (const Link& l : links) {
+    if (l.target.find("://") != std::string::npos) {
+      bool https = l.target.rfind("https://", 0) == 0;
+      if (!https && l.target.rfind("http://", 0) != 0) continue;
+      std::string rest = l.target.substr(https ? 8 : 7);
+      std::string host = rest.substr(0, rest.find_first_of("/:?"));
+      if (!host.empty()) {
+        hosts.insert({host, static_cast<uint16_t>(https ? 443 : 80)});
+      }
+      continue;
+    }
+    checked_internal++;
+    if (!internal_target_exists(dist, l.target)) {
+      std::fprintf(stderr, "linkcheck: dead link in %s: %s\n",
+                   l.page.c_str(), l.target.c_str());
+      dead++;
+    } else if (l.stylesheet) {
+      preload << l.page << " " << l.target << "\n";
+    }
+  }
+  preload.close();
+
+  int unreachable = 0;
+  if (external && !hosts.empty()) {
+    std::vector<Probe> probes;
+    for (const auto& [host, port] : hosts) probes.push_back({host, port});
+    probe_external(&probes, max_conns);
+    for (const Probe& pr : probes) {
+      if (!pr.ok) {
+        std::fprintf(stderr, "linkcheck: warn: %s:%u unreachable\n",
+                     pr.host.c_str(), pr.port);
+        unreachable++;
+      }
+    }
+  }
+
+  std::fprintf(stderr,
+               "linkcheck: %d internal checked (%d dead), %zu external "
+               "host%s%s%d unreachable\n",
+               checked_internal, dead, hosts.size(),
+               hosts.size() == 1 ? "" : "s",
+               external ? " probed, " : " found (not probed), ",
+               unreachable);
+  return dead == 0 ? 0 : 1;
+}
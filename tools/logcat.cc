@@ -0,0 +1,140 @@
+// logcat: renders the binary access log as CLF or JSON lines.
+//
+// The server writes fixed 32-byte records (srv/access_log.h) behind an
+// asset name table; this tool is the only thing that needs to understand
+// the format, so the hot path never formats text.
+//
+// The "hot" format aggregates instead of rendering: one "hits name" line
+// per asset, most-fetched first, with content-hashed aliases folded into
+// their canonical name.  That file is the hotness ranking precompress -H
+// consumes to pick compression effort per asset.
+//
+//   usage: logcat [-f clf|json|hot] access.blog
+
+#include <arpa/inet.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "srv/access_log.h"
+
+namespace {
+
+// /stem.<16 hex>.ext -> stem.ext: both names of a hashed asset count as
+// one line in the hotness ranking, and the leading slash goes so the name
+// matches what precompress sees on disk.
+std::string canonical_name(std::string name) {
+  if (!name.empty() && name[0] == '/') name = name.substr(1);
+  size_t dot = name.rfind('.');
+  if (dot == std::string::npos || dot < 17 || name[dot - 17] != '.') {
+    return name;
+  }
+  for (size_t i = dot - 16; i < dot; i++) {
+    char c = name[i];
+    if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return name;
+  }
+  return name.substr(0, dot - 17) + name.substr(dot);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string fmt = "clf";
+  std::string path;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "-f") && i + 1 < argc) fmt = argv[++i];
+    else if (path.empty()) path = argv[i];
+    else {
+      std::fprintf(stderr, "usage: %s [-f clf|json|hot] access.blog\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+  if (path.empty() || (fmt != "clf" && fmt != "json" && fmt != "hot")) {
+    std::fprintf(stderr, "usage: %s [-f clf|json|hot] access.blog\n",
+                 argv[0]);
+    return 2;
+  }
+
+  std::ifstream f(path, std::ios::binary);
+  if (!f) {
+    std::fprintf(stderr, "logcat: cannot open %s\n", path.c_str());
+    return 1;
+  }
+
+  char magic[4];
+  uint32_t count = 0;
+  f.read(magic, 4);
+  f.read(reinterpret_cast<char*>(&count), 4);
+  if (!f || std::memcmp(magic, vsite::kLogMagic, 4) != 0) {
+    std::fprintf(stderr, "logcat: %s is not an access log\n", path.c_str());
+    return 1;
+  }
+  std::vector<std::string> names(count);
+  for (uint32_t i = 0; i < count; i++) {
+    uint8_t len = 0;
+    f.read(reinterpret_cast<char*>(&len), 1);
+    names[i].resize(len);
+    f.read(names[i].data(), len);
+  }
+
+  if (fmt == "hot") {
+    std::vector<uint64_t> hits(count, 0);
+    vsite::LogRecord r;
+    while (f.read(reinterpret_cast<char*>(&r), sizeof(r))) {
+      if (r.status / 100 != 2) continue;  // 404s are not asset demand
+      if (r.asset_idx >= 0 && r.asset_idx < static_cast<int>(count)) {
+        hits[r.asset_idx]++;
+      }
+    }
+    std::vector<std::pair<uint64_t, std::string>> ranked;
+    for (uint32_t i = 0; i < count; i++) {
+      if (hits[i] == 0) continue;
+      std::string name = canonical_name(names[i]);
+      auto it = std::find_if(ranked.begin(), ranked.end(),
+                             [&](const auto& p) { return p.second == name; });
+      if (it != ranked.end()) it->first += hits[i];
+      else ranked.push_back({hits[i], name});
+    }
+    std::sort(ranked.begin(), ranked.end(),
+              [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (const auto& [n, name] : ranked) {
+      std::printf("%llu %s\n", static_cast<unsigned long long>(n),
+                  name.c_str());
+    }
+    return 0;
+  }
+
+  vsite::LogRecord r;
+  while (f.read(reinterpret_cast<char*>(&r), sizeof(r))) {
+    struct in_addr ip = {r.peer_ip};
+    const char* p = (r.asset_idx >= 0 &&
+                     r.asset_idx < static_cast<int>(names.size()))
+                        ? names[r.asset_idx].c_str()
+                        : "-";
+    const char* method = r.is_head ? "HEAD" : "GET";
+    static const char* const kEnc[] = {"identity", "gzip", "br", "zstd"};
+    const char* enc = r.encoding < 4 ? kEnc[r.encoding] : "?";
+    if (fmt == "clf") {
+      // Monotonic timestamps do not map to wall time; CLF output carries
+      // the raw nanoseconds where the date would go.
+      std::printf("%s - - [%llu] \"%s %s HTTP/1.1\" %u %u %uus\n",
+                  inet_ntoa(ip),
+                  static_cast<unsigned long long>(r.ts_ns), method, p,
+                  r.status, r.resp_bytes, r.latency_us);
+    } else {
+      std::printf(
+          "{\"ip\":\"%s\",\"ts_ns\":%llu,\"method\":\"%s\",\"path\":\"%s\","
+          "\"status\":%u,\"bytes\":%u,\"latency_us\":%u,\"encoding\":\"%s\"}"
+          "\n",
+          inet_ntoa(ip), static_cast<unsigned long long>(r.ts_ns), method,
+          p, r.status, r.resp_bytes, r.latency_us, enc);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,172 @@
+// minify_html: strips comments and collapses whitespace between tags.
+//
+// Plain text is scanned eight bytes at a time with SWAR classification
+// (broadcast-XOR + the has-zero-byte trick) to find the next '<' or
+// whitespace, so minification stays a memcpy-speed pass even across
+// hundreds of generated pages.  Behaviour:
+//
+//  * <!-- comments --> are dropped entirely;
+//  * whitespace-only text between tags is dropped, other whitespace runs
+//    collapse to a single space;
+//  * <pre>, <script> and <style> contents pass through untouched;
+//  * everything else is copied verbatim, so output is deterministic and
+//    byte-stable -- ETags and precompressed variants stay reproducible.
+//
+//   usage: minify_html <input.html> <output.html>
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+bool is_space(char ch) {
+  return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == '\f';
+}
+
+// SWAR has-zero: after XORing a word with a broadcast byte, any zero lane
+// sets the high bit of that lane in (x - 0x01..) & ~x & 0x80...
+inline uint64_t lanes_eq(uint64_t word, uint8_t byte) {
+  uint64_t x = word ^ (0x0101010101010101ull * byte);
+  return (x - 0x0101010101010101ull) & ~x & 0x8080808080808080ull;
+}
+
+// Index of the first '<' or whitespace byte at or after pos, or len.
+size_t scan_text(const char* data, size_t len, size_t pos) {
+  while (pos + 8 <= len) {
+    uint64_t w;
+    std::memcpy(&w, data + pos, 8);
+    uint64_t hit = lanes_eq(w, '<') | lanes_eq(w, ' ') | lanes_eq(w, '\t') |
+                   lanes_eq(w, '\n') | lanes_eq(w, '\r') | lanes_eq(w, '\f');
+    if (hit != 0) return pos + __builtin_ctzll(hit) / 8;
+    pos += 8;
+  }
+  while (pos < len && data[pos] != '<' && !is_space(data[pos])) pos++;
+  return pos;
+}
+
+// Lowercased tag name starting right after '<' (or "</"), e.g. "style".
+std::string tag_name(const std::string& s, size_t lt) {
+  size_t p = lt + 1;
+  if (p < s.size() && s[p] == '/') p++;
+  std::string name;
+  while (p < s.size() &&
+         (std::isalnum(static_cast<unsigned char>(s[p])) || s[p] == '-')) {
+    name += static_cast<char>(
+        std::tolower(static_cast<unsigned char>(s[p++])));
+  }
+  return name;
+}
+
+// End of the tag starting at lt (index one past '>'), honouring quoted
+// attribute values that may contain '>'.
+size_t tag_end(const std::string& s, size_t lt) {
+  char quote = 0;
+  for (size_t i = lt; i < s.size(); i++) {
+    char ch = s[i];
+    if (quote != 0) {
+      if (ch == quote) quote = 0;
+    } else if (ch == '"' || ch == '\'') {
+      quote = ch;
+    } else if (ch == '>') {
+      return i + 1;
+    }
+  }
+  return s.size();
+}
+
+bool raw_text_tag(const std::string& name) {
+  return name == "pre" || name == "script" || name == "style" ||
+         name == "textarea";
+}
+
+std::string minify(const std::string& src) {
+  std::string out;
+  out.reserve(src.size());
+  size_t pos = 0;
+
+  while (pos < src.size()) {
+    char ch = src[pos];
+    if (ch == '<') {
+      if (src.compare(pos, 4, "<!--") == 0) {
+        size_t end = src.find("-->", pos);
+        pos = end == std::string::npos ? src.size() : end + 3;
+        continue;
+      }
+      size_t lt = pos;
+      size_t end = tag_end(src, pos);
+      std::string name = tag_name(src, lt);
+      out.append(src, lt, end - lt);
+      pos = end;
+      bool opening = src[lt + 1] != '/' && end >= 2 && src[end - 2] != '/';
+      if (raw_text_tag(name) && opening) {
+        // Opening raw-text element: copy everything through its close tag
+        // verbatim; whitespace inside <pre>/<style>/<script> is content.
+        std::string close = "</" + name;
+        size_t c = src.find(close, pos);
+        size_t cend = c == std::string::npos ? src.size() : tag_end(src, c);
+        out.append(src, pos, cend - pos);
+        pos = cend;
+      }
+      continue;
+    }
+    if (is_space(ch)) {
+      size_t end = pos;
+      bool has_newline = false;
+      while (end < src.size() && is_space(src[end])) {
+        if (src[end] == '\n' || src[end] == '\r') has_newline = true;
+        end++;
+      }
+      // Indentation between two tags (a run with a newline, '>' behind and
+      // '<' ahead) is formatting and vanishes.  Any other run -- including
+      // the visible space around inline elements like <a> -- collapses to
+      // exactly one space so rendering is unchanged.
+      bool between_tags = !out.empty() && out.back() == '>' &&
+                          end < src.size() && src[end] == '<';
+      bool at_edge = out.empty() || end >= src.size();
+      if (!((between_tags && has_newline) || at_edge)) out += ' ';
+      pos = end;
+      continue;
+    }
+    size_t end = scan_text(src.data(), src.size(), pos);
+    out.append(src, pos, end - pos);
+    pos = end;
+  }
+  return out;
+}
+
+}  // namespace
+
+// The fuzz harness (fuzz/fuzz_minify_html.cc) includes this file with the
+// entry point compiled out.
+#ifndef MINIFY_HTML_NO_MAIN
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    std::fprintf(stderr, "usage: %s <input.html> <output.html>\n", argv[0]);
+    return 2;
+  }
+  std::ifstream in(argv[1], std::ios::binary);
+  if (!in) {
+    std::fprintf(stderr, "minify_html: cannot read %s\n", argv[1]);
+    return 1;
+  }
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  const std::string src = ss.str();
+  const std::string out = minify(src);
+
+  std::ofstream of(argv[2], std::ios::binary | std::ios::trunc);
+  if (!of || !of.write(out.data(), out.size())) {
+    std::fprintf(stderr, "minify_html: cannot write %s\n", argv[2]);
+    return 1;
+  }
+  std::fprintf(stderr, "minify_html: %s -> %s (%zu -> %zu bytes, -%.0f%%)\n",
+               argv[1], argv[2], src.size(), out.size(),
+               src.empty() ? 0.0 : 100.0 - 100.0 * out.size() / src.size());
+  return 0;
+}
+#endif  // MINIFY_HTML_NO_MAIN
@@ -0,0 +1,305 @@
+// mkindex: builds the prefix-search index (srv/search_index.h) over the
+// built site's text.
+//
+// Pages contribute their visible text (tags, scripts and styles stripped,
+// the common entities decoded); PDFs contribute whatever text operators
+// can be recovered by inflating their streams and scanning BT..ET blocks
+// -- best effort, which is all a search box needs.  Content-hashed aliases
+// are skipped so each document indexes once under its canonical name.
+// Terms are lowercased [a-z0-9]+ runs, 2..32 chars.
+//
+// The index is written tmp-then-rename like every other deploy artifact.
+//
+//   usage: mkindex [-d dist_dir] [-o index_file]
+
+#include <zlib.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "srv/search_index.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string read_file(const fs::path& p) {
+  std::ifstream f(p, std::ios::binary);
+  std::ostringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+bool is_hashed_alias(const std::string& name) {
+  size_t dot = name.rfind('.');
+  if (dot == std::string::npos || dot < 17 || name[dot - 17] != '.') {
+    return false;
+  }
+  for (size_t i = dot - 16; i < dot; i++) {
+    char c = name[i];
+    if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+  }
+  return true;
+}
+
+// Visible text of a built (minified) page: tags dropped, script/style
+// elements skipped whole, the entities the minifier leaves decoded.
+std::string html_text(const std::string& html) {
+  std::string text;
+  size_t pos = 0;
+  while (pos < html.size()) {
+    if (html[pos] == '<') {
+      size_t end = html.find('>', pos);
+      if (end == std::string::npos) break;
+      std::string tag = html.substr(pos + 1, end - pos - 1);
+      for (const char* skip : {"script", "style"}) {
+        if (tag.rfind(skip, 0) == 0) {
+          std::string close = std::string("</") + skip;
+          size_t c = html.find(close, end);
+          end = c == std::string::npos ? html.size()
+                                       : html.find('>', c);
+          break;
+        }
+      }
+      pos = end == std::string::npos ? html.size() : end + 1;
+      text += ' ';
+      continue;
+    }
+    if (html[pos] == '&') {
+      static const std::pair<const char*, char> kEntities[] = {
+          {"&amp;", '&'}, {"&lt;", '<'}, {"&gt;", '>'},
+          {"&quot;", '"'}, {"&#39;", '\''}, {"&nbsp;", ' '},
+      };
+      bool matched = false;
+      for (const auto& [ent, ch] : kEntities) {
+        size_t n = std::strlen(ent);
+        if (html.compare(pos, n, ent) == 0) {
+          text += ch;
+          pos += n;
+          matched = true;
+          break;
+        }
+      }
+      if (matched) continue;
+    }
+    text += html[pos++];
+  }
+  return text;
+}
+
+// Collects parenthesized strings inside BT..ET blocks (Tj/TJ operands),
+// with the minimal escape handling real generators use.  Fragments are
+// joined without separators -- kerned output splits words across many
+// small strings in one TJ array -- and a word break is inserted only at
+// the operators that move the text position (Td/TD/T*/Tm and the show
+// operators themselves).
+void pdf_text_ops(const std::string& data, std::string* text) {
+  size_t pos = 0;
+  while ((pos = data.find("BT", pos)) != std::string::npos) {
+    size_t end = data.find("ET", pos);
+    if (end == std::string::npos) end = data.size();
+    for (size_t i = pos; i < end; i++) {
+      if (data[i] == '(') {
+        for (i++; i < end && data[i] != ')'; i++) {
+          if (data[i] == '\\' && i + 1 < end) {
+            i++;
+            if (data[i] == '(' || data[i] == ')' || data[i] == '\\') {
+              text->push_back(data[i]);
+            }
+            continue;
+          }
+          text->push_back(data[i]);
+        }
+        continue;
+      }
+      if (data[i] == '-') {
+        // In a TJ array a large negative kern is how generators encode an
+        // inter-word space; small ones are letter fitting.
+        uint32_t v = 0;
+        size_t j = i + 1;
+        while (j < end && data[j] >= '0' && data[j] <= '9') {
+          v = v * 10 + (data[j] - '0');
+          j++;
+        }
+        if (v >= 150) text->push_back(' ');
+        i = j - 1;
+        continue;
+      }
+      if (data[i] == 'T' && i + 1 < end &&
+          (data[i + 1] == 'j' || data[i + 1] == 'J' || data[i + 1] == 'd' ||
+           data[i + 1] == 'D' || data[i + 1] == '*' || data[i + 1] == 'm')) {
+        text->push_back(' ');
+        i++;
+      }
+    }
+    text->push_back(' ');
+    pos = end;
+  }
+}
+
+// Best-effort PDF text: every stream object is inflated (FlateDecode is
+// what every generator emits) and scanned for text operators; streams that
+// do not inflate are scanned raw.  Fonts with custom encodings come out as
+// garbage tokens that simply never match a query.
+std::string pdf_text(const std::string& pdf) {
+  std::string text;
+  size_t pos = 0;
+  while ((pos = pdf.find("stream", pos)) != std::string::npos) {
+    size_t start = pos + 6;
+    if (start < pdf.size() && pdf[start] == '\r') start++;
+    if (start < pdf.size() && pdf[start] == '\n') start++;
+    size_t end = pdf.find("endstream", start);
+    if (end == std::string::npos) break;
+
+    std::string inflated;
+    z_stream zs{};
+    if (inflateInit(&zs) == Z_OK) {
+      inflated.resize((end - start) * 8 + 1024);
+      zs.next_in = reinterpret_cast<Bytef*>(
+          const_cast<char*>(pdf.data() + start));
+      zs.avail_in = end - start;
+      zs.next_out = reinterpret_cast<Bytef*>(inflated.data());
+      zs.avail_out = inflated.size();
+      int rc = inflate(&zs, Z_FINISH);
+      inflateEnd(&zs);
+      if (rc == Z_STREAM_END) inflated.resize(zs.total_out);
+      else inflated.clear();
+    }
+    if (!inflated.empty()) pdf_text_ops(inflated, &text);
+    else pdf_text_ops(pdf.substr(start, end - start), &text);
+    pos = end + 9;
+  }
+  return text;
+}
+
+void tokenize(const std::string& text,
+              std::map<std::string, uint16_t>* counts) {
+  std::string term;
+  for (size_t i = 0; i <= text.size(); i++) {
+    char c = i < text.size() ? text[i] : ' ';
+    if (c >= 'A' && c <= 'Z') c = static_cast<char>(c | 0x20);
+    if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+      term += c;
+      continue;
+    }
+    if (term.size() >= 2 && term.size() <= 32) {
+      uint16_t& n = (*counts)[term];
+      if (n != UINT16_MAX) n++;
+    }
+    term.clear();
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  fs::path dist = "dist";
+  fs::path out_path;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "-d") && i + 1 < argc) dist = argv[++i];
+    else if (!std::strcmp(argv[i], "-o") && i + 1 < argc)
+      out_path = argv[++i];
+    else {
+      std::fprintf(stderr, "usage: %s [-d dist_dir] [-o index_file]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+  if (out_path.empty()) out_path = dist / ".searchidx";
+
+  // page name -> term -> count
+  std::vector<std::string> pages;
+  std::vector<std::map<std::string, uint16_t>> page_terms;
+  for (const auto& ent : fs::directory_iterator(dist)) {
+    if (!ent.is_regular_file()) continue;
+    std::string name = ent.path().filename().string();
+    std::string ext = ent.path().extension().string();
+    if ((ext != ".html" && ext != ".pdf") || is_hashed_alias(name)) continue;
+    std::string raw = read_file(ent.path());
+    std::string text = ext == ".html" ? html_text(raw) : pdf_text(raw);
+    std::map<std::string, uint16_t> counts;
+    tokenize(text, &counts);
+    if (counts.empty()) continue;
+    pages.push_back(name);
+    page_terms.push_back(std::move(counts));
+  }
+
+  // Invert: term -> postings, already sorted because the map is.
+  std::map<std::string, std::vector<vsite::SearchPosting>> terms;
+  for (size_t pg = 0; pg < pages.size(); pg++) {
+    for (const auto& [term, count] : page_terms[pg]) {
+      terms[term].push_back({static_cast<uint16_t>(pg), count});
+    }
+  }
+
+  // Lay out blob, term records and postings.
+  std::string blob;
+  std::vector<uint32_t> page_offs;
+  for (const std::string& p : pages) {
+    page_offs.push_back(static_cast<uint32_t>(blob.size()));
+    blob += p;
+    blob += '\0';
+  }
+  std::vector<vsite::SearchTerm> term_recs;
+  std::vector<vsite::SearchPosting> postings;
+  for (const auto& [term, posts] : terms) {
+    vsite::SearchTerm t{};
+    t.str_off = static_cast<uint32_t>(blob.size());
+    t.post_off = static_cast<uint32_t>(postings.size());
+    t.post_count = static_cast<uint16_t>(posts.size());
+    blob += term;
+    blob += '\0';
+    term_recs.push_back(t);
+    postings.insert(postings.end(), posts.begin(), posts.end());
+  }
+
+  vsite::SearchHeader hdr{};
+  std::memcpy(hdr.magic, vsite::kSearchMagic, 4);
+  hdr.page_count = static_cast<uint32_t>(pages.size());
+  hdr.term_count = static_cast<uint32_t>(term_recs.size());
+  hdr.pages_off = sizeof(hdr);
+  hdr.terms_off = hdr.pages_off +
+                  static_cast<uint32_t>(page_offs.size() * sizeof(uint32_t));
+  hdr.postings_off =
+      hdr.terms_off +
+      static_cast<uint32_t>(term_recs.size() * sizeof(vsite::SearchTerm));
+  hdr.blob_off =
+      hdr.postings_off +
+      static_cast<uint32_t>(postings.size() * sizeof(vsite::SearchPosting));
+
+  fs::path tmp = out_path;
+  tmp += ".tmp";
+  std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+  f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+  f.write(reinterpret_cast<const char*>(page_offs.data()),
+          page_offs.size() * sizeof(uint32_t));
+  f.write(reinterpret_cast<const char*>(term_recs.data()),
+          term_recs.size() * sizeof(vsite::SearchTerm));
+  f.write(reinterpret_cast<const char*>(postings.data()),
+          postings.size() * sizeof(vsite::SearchPosting));
+  f.write(blob.data(), blob.size());
+  if (!f.good()) {
+    std::fprintf(stderr, "mkindex: cannot write %s\n", tmp.c_str());
+    return 1;
+  }
+  f.close();
+  std::error_code ec;
+  fs::rename(tmp, out_path, ec);
+  if (ec) {
+    std::fprintf(stderr, "mkindex: rename failed: %s\n",
+                 ec.message().c_str());
+    return 1;
+  }
+
+  std::fprintf(stderr, "mkindex: %zu pages, %zu terms, %zu postings -> %s\n",
+               pages.size(), term_recs.size(), postings.size(),
+               out_path.c_str());
+  return 0;
+}
@@ -0,0 +1,148 @@
+// pack: bundles a built dist/ tree into one deployable image.
+//
+// Deploying files one by one leaves a window where the tree is internally
+// inconsistent (new page, old stylesheet).  A pack is copied as a single
+// file and swapped in with one rename, so the server flips between complete
+// generations; rollback is re-deploying the previous image.  See
+// srv/pack_format.h for the layout.
+//
+//   usage: pack [-i dist_dir] [-o site.pack]
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "srv/pack_format.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Input {
+  std::string name;  // base name (variant extension stripped)
+  uint8_t encoding;
+  std::string bytes;
+};
+
+// Maps on-disk names to pack entries: "index.html.br" is the brotli variant
+// of "index.html", ".preload" is metadata, other dotfiles are build state
+// and stay out of the image.
+bool classify(const fs::path& p, Input* in) {
+  std::string name = p.filename().string();
+  in->encoding = 0;
+  // A previous image living in the tree must not be packed into the next.
+  if (p.extension() == ".pack") return false;
+  if (name[0] == '.') {
+    if (name != ".preload") return false;
+    in->encoding = vsite::kPackMeta;
+  } else {
+    for (const auto& [ext, enc] :
+         {std::pair<const char*, uint8_t>{".gz", 1}, {".br", 2},
+          {".zst", 3}}) {
+      size_t n = std::strlen(ext);
+      if (name.size() > n && name.compare(name.size() - n, n, ext) == 0) {
+        name.resize(name.size() - n);
+        in->encoding = enc;
+        break;
+      }
+    }
+  }
+  if (name.size() >= sizeof(vsite::PackEntry{}.name)) {
+    std::fprintf(stderr, "pack: name too long, skipped: %s\n", name.c_str());
+    return false;
+  }
+  in->name = name;
+  std::ifstream f(p, std::ios::binary);
+  std::ostringstream ss;
+  ss << f.rdbuf();
+  in->bytes = ss.str();
+  return !in->bytes.empty();
+}
+
+uint64_t fnv1a64(const std::string& bytes) {
+  uint64_t h = 0xcbf29ce484222325ull;
+  for (unsigned char c : bytes) {
+    h ^= c;
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  fs::path in_dir = "dist";
+  fs::path out_path = "site.pack";
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "-i") && i + 1 < argc) in_dir = argv[++i];
+    else if (!std::strcmp(argv[i], "-o") && i + 1 < argc)
+      out_path = argv[++i];
+    else {
+      std::fprintf(stderr, "usage: %s [-i dist_dir] [-o site.pack]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+
+  std::vector<Input> inputs;
+  for (const auto& ent : fs::directory_iterator(in_dir)) {
+    if (!ent.is_regular_file()) continue;
+    Input in;
+    if (classify(ent.path(), &in)) inputs.push_back(std::move(in));
+  }
+  if (inputs.empty()) {
+    std::fprintf(stderr, "pack: nothing to pack in %s\n", in_dir.c_str());
+    return 1;
+  }
+
+  vsite::PackHeader hdr{};
+  std::memcpy(hdr.magic, vsite::kPackMagic, 4);
+  hdr.count = static_cast<uint32_t>(inputs.size());
+
+  std::vector<vsite::PackEntry> index(inputs.size());
+  uint64_t off = sizeof(hdr) + index.size() * sizeof(vsite::PackEntry);
+  for (size_t i = 0; i < inputs.size(); i++) {
+    off = (off + vsite::kPackAlign - 1) & ~(vsite::kPackAlign - 1);
+    index[i] = vsite::PackEntry{};
+    std::strncpy(index[i].name, inputs[i].name.c_str(),
+                 sizeof(index[i].name) - 1);
+    index[i].encoding = inputs[i].encoding;
+    index[i].offset = off;
+    index[i].size = inputs[i].bytes.size();
+    index[i].hash = fnv1a64(inputs[i].bytes);
+    off += inputs[i].bytes.size();
+  }
+
+  // Write to a temp name and rename so a watcher never maps a half-written
+  // image -- the same discipline the server relies on for deploys.
+  fs::path tmp = out_path.string() + ".tmp";
+  std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+  f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+  f.write(reinterpret_cast<const char*>(index.data()),
+          index.size() * sizeof(vsite::PackEntry));
+  uint64_t pos = sizeof(hdr) + index.size() * sizeof(vsite::PackEntry);
+  for (size_t i = 0; i < inputs.size(); i++) {
+    while (pos < index[i].offset) {
+      f.put('\0');
+      pos++;
+    }
+    f.write(inputs[i].bytes.data(), inputs[i].bytes.size());
+    pos += inputs[i].bytes.size();
+  }
+  if (!f.good()) {
+    std::fprintf(stderr, "pack: write failed: %s\n", tmp.c_str());
+    return 1;
+  }
+  f.close();
+  fs::rename(tmp, out_path);
+
+  std::fprintf(stderr, "pack: %zu entries, %llu bytes -> %s\n",
+               inputs.size(), static_cast<unsigned long long>(pos),
+               out_path.c_str());
+  return 0;
+}
@@ -0,0 +1,220 @@
+// precompress: emits .gz/.br (and .zst where libzstd is available) siblings
+// for each input file, so the server never compresses the same bytes twice.
+// Compression happens once per deploy; every request then gets the
+// precompressed variant via the zero-copy path.
+//
+// Effort is per asset.  Without a hotness ranking everything gets maximum
+// effort, the only defensible default when nothing is known.  With one
+// (-H file of "hits name" lines, logcat -f hot), the assets carrying the
+// top 90% of traffic keep max effort and the long tail drops to fast
+// levels -- brotli-11 on a gallery photo fetched once a week buys nothing
+// for its minutes of build time.  The ranking-to-effort mapping is a
+// policy object so alternatives slot in without touching the codecs.
+//
+// A sibling is only written when it is actually smaller than the original;
+// content negotiation in the server falls back to identity otherwise.
+//
+//   usage: precompress [-H hotness] <file>...
+
+#include <zlib.h>
+#include <brotli/encode.h>
+#if HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool read_file(const std::string& path, std::string* out) {
+  std::ifstream f(path, std::ios::binary);
+  if (!f) return false;
+  std::ostringstream ss;
+  ss << f.rdbuf();
+  *out = ss.str();
+  return true;
+}
+
+bool write_file(const std::string& path, const std::string& data) {
+  std::ofstream f(path, std::ios::binary | std::ios::trunc);
+  return f && f.write(data.data(), data.size()).good();
+}
+
+bool gzip_compress(const std::string& in, std::string* out, bool hot) {
+  z_stream zs{};
+  // windowBits 15+16 selects the gzip wrapper.
+  if (deflateInit2(&zs, hot ? Z_BEST_COMPRESSION : 6, Z_DEFLATED, 15 + 16, 9,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  out->resize(deflateBound(&zs, in.size()));
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = in.size();
+  zs.next_out = reinterpret_cast<Bytef*>(out->data());
+  zs.avail_out = out->size();
+  int rc = deflate(&zs, Z_FINISH);
+  deflateEnd(&zs);
+  if (rc != Z_STREAM_END) return false;
+  out->resize(zs.total_out);
+  return true;
+}
+
+bool brotli_compress(const std::string& in, std::string* out, bool hot) {
+  size_t out_size = BrotliEncoderMaxCompressedSize(in.size());
+  out->resize(out_size);
+  if (!BrotliEncoderCompress(hot ? BROTLI_MAX_QUALITY : 5,
+                             BROTLI_MAX_WINDOW_BITS,
+                             BROTLI_DEFAULT_MODE, in.size(),
+                             reinterpret_cast<const uint8_t*>(in.data()),
+                             &out_size,
+                             reinterpret_cast<uint8_t*>(out->data()))) {
+    return false;
+  }
+  out->resize(out_size);
+  return true;
+}
+
+#if HAVE_ZSTD
+bool zstd_compress(const std::string& in, std::string* out, bool hot) {
+  out->resize(ZSTD_compressBound(in.size()));
+  size_t n = ZSTD_compress(out->data(), out->size(), in.data(), in.size(),
+                           hot ? 19 : 3);
+  if (ZSTD_isError(n)) return false;
+  out->resize(n);
+  return true;
+}
+#endif
+
+struct Codec {
+  const char* ext;
+  bool (*compress)(const std::string&, std::string*, bool hot);
+};
+
+const std::vector<Codec> kCodecs = {
+    {".gz", gzip_compress},
+    {".br", brotli_compress},
+#if HAVE_ZSTD
+    {".zst", zstd_compress},
+#endif
+};
+
+// Maps an asset to the effort its traffic justifies.  Virtual so a
+// different ranking (size-weighted, recency-decayed) can be tried without
+// touching the codec table.
+class LevelPolicy {
+ public:
+  virtual ~LevelPolicy() = default;
+  virtual bool hot(const std::string& name) const = 0;
+};
+
+// No ranking available: compress everything as hard as possible.
+class MaxEffortPolicy : public LevelPolicy {
+ public:
+  bool hot(const std::string&) const override { return true; }
+};
+
+// Ranking-driven: hot is the smallest prefix of the ranking that covers
+// kHotShare of observed hits.  Assets absent from the ranking were never
+// fetched while it was collected and stay cold.
+class HotnessPolicy : public LevelPolicy {
+ public:
+  static constexpr double kHotShare = 0.90;
+
+  static std::unique_ptr<HotnessPolicy> load(const std::string& path) {
+    std::ifstream f(path);
+    if (!f) return nullptr;
+    auto p = std::unique_ptr<HotnessPolicy>(new HotnessPolicy);
+    // "hits name" per line, most-fetched first (logcat -f hot).
+    std::vector<std::pair<uint64_t, std::string>> ranked;
+    uint64_t hits, total = 0;
+    std::string name;
+    while (f >> hits >> name) {
+      ranked.push_back({hits, name});
+      total += hits;
+    }
+    uint64_t cum = 0;
+    for (const auto& [n, nm] : ranked) {
+      if (total != 0 && cum >= static_cast<uint64_t>(total * kHotShare)) break;
+      p->hot_.insert(nm);
+      cum += n;
+    }
+    return p;
+  }
+
+  bool hot(const std::string& name) const override {
+    return hot_.count(name) != 0;
+  }
+
+ private:
+  HotnessPolicy() = default;
+  std::set<std::string> hot_;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::unique_ptr<LevelPolicy> policy = std::make_unique<MaxEffortPolicy>();
+  std::vector<const char*> files;
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "-H") && i + 1 < argc) {
+      auto hp = HotnessPolicy::load(argv[++i]);
+      if (!hp) {
+        std::fprintf(stderr, "precompress: cannot read ranking %s\n",
+                     argv[i]);
+        return 2;
+      }
+      policy = std::move(hp);
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if (files.empty()) {
+    std::fprintf(stderr, "usage: %s [-H hotness] <file>...\n", argv[0]);
+    return 2;
+  }
+  int failures = 0;
+  for (const char* file : files) {
+    std::string in;
+    if (!read_file(file, &in)) {
+      std::fprintf(stderr, "precompress: cannot read %s\n", file);
+      failures++;
+      continue;
+    }
+    // The ranking speaks canonical URL names; match on the filename.
+    bool hot = policy->hot(std::filesystem::path(file).filename().string());
+    for (const Codec& c : kCodecs) {
+      std::string out;
+      if (!c.compress(in, &out, hot)) {
+        std::fprintf(stderr, "precompress: %s%s: compression failed\n",
+                     file, c.ext);
+        failures++;
+        continue;
+      }
+      if (out.size() >= in.size()) {
+        std::fprintf(stderr, "precompress: %s%s: not smaller, skipped\n",
+                     file, c.ext);
+        continue;
+      }
+      if (!write_file(std::string(file) + c.ext, out)) {
+        std::fprintf(stderr, "precompress: cannot write %s%s\n", file,
+                     c.ext);
+        failures++;
+        continue;
+      }
+      std::fprintf(stderr,
+                   "precompress: %s%s: %zu -> %zu bytes (%.0f%%, %s)\n",
+                   file, c.ext, in.size(), out.size(),
+                   100.0 * out.size() / in.size(),
+                   hot ? "max effort" : "fast");
+    }
+  }
+  return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,459 @@
+// sitegen: treats the repo as a content tree and builds dist/ from it.
+//
+// Pages are the *.html files in the source root (and pages/ if present);
+// everything else that ships -- stylesheets, PDFs, CNAME -- is a copy-through
+// asset.  Each output records the FNV-1a hashes of its inputs (the page plus
+// any local stylesheet it inlines) in dist/.sitegen.state; on the next run
+// only outputs whose input hashes changed are rebuilt, so touching one page
+// rebuilds one page, not the world.
+//
+// Pages run through the existing pipeline stages (inline_assets, then
+// minify_html, then precompress), found next to this binary.  Assets other
+// than CNAME are additionally emitted under a content-addressed name
+// (stem.<16 hex>.ext) and page references are rewritten to it, so the
+// server can mark those URLs immutable for a year; the canonical name stays
+// alongside for direct links.  The tool reports wall time and rebuilt
+// counts for both cold and warm runs.
+//
+//   usage: sitegen [-s source_root] [-o out_dir]
+
+#include <time.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+uint64_t now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+uint64_t fnv1a64_file(const fs::path& p) {
+  std::ifstream f(p, std::ios::binary);
+  if (!f) return 0;
+  uint64_t h = 0xcbf29ce484222325ull;
+  char buf[65536];
+  while (f.read(buf, sizeof(buf)) || f.gcount() > 0) {
+    for (std::streamsize i = 0; i < f.gcount(); i++) {
+      h ^= static_cast<uint8_t>(buf[i]);
+      h *= 0x100000001b3ull;
+    }
+  }
+  return h;
+}
+
+// Local href/src values in a page: these are its build dependencies (the
+// inliner pulls stylesheets in) and, later, its outgoing internal links.
+std::vector<std::string> local_refs(const fs::path& page) {
+  std::vector<std::string> refs;
+  std::ifstream f(page, std::ios::binary);
+  std::ostringstream ss;
+  ss << f.rdbuf();
+  std::string html = ss.str();
+  for (const char* attr : {"href=\"", "src=\""}) {
+    size_t pos = 0;
+    while ((pos = html.find(attr, pos)) != std::string::npos) {
+      pos += std::strlen(attr);
+      size_t end = html.find('"', pos);
+      if (end == std::string::npos) break;
+      std::string ref = html.substr(pos, end - pos);
+      if (!ref.empty() && ref.find("://") == std::string::npos &&
+          ref[0] != '#' && ref[0] != '/') {
+        refs.push_back(ref);
+      }
+      pos = end;
+    }
+  }
+  return refs;
+}
+
+struct Node {
+  fs::path src;                  // source file
+  std::string out_name;          // name within the output dir
+  std::string hashed_name;       // content-addressed alias ("" for pages)
+  bool is_page = false;
+  std::vector<fs::path> deps;    // src plus inlined/rewritten inputs
+  uint64_t input_hash = 0;       // combined hash of all deps + knobs
+  uint64_t content_hash = 0;     // deps only; what lastmod tracking keys on
+};
+
+std::string hashed_name_for(const std::string& name, uint64_t hash) {
+  size_t dot = name.rfind('.');
+  if (dot == std::string::npos) return "";
+  char hex[17];
+  std::snprintf(hex, sizeof(hex), "%016llx",
+                static_cast<unsigned long long>(hash));
+  return name.substr(0, dot) + "." + hex + name.substr(dot);
+}
+
+// Replaces href/src references to canonical asset names with their hashed
+// aliases in an already-built page.
+bool rewrite_refs(const fs::path& page,
+                  const std::map<std::string, std::string>& aliases) {
+  std::ifstream f(page, std::ios::binary);
+  if (!f) return false;
+  std::ostringstream ss;
+  ss << f.rdbuf();
+  std::string html = ss.str();
+  for (const auto& [name, hashed] : aliases) {
+    const std::string from = "\"" + name + "\"";
+    const std::string to = "\"" + hashed + "\"";
+    size_t pos = 0;
+    while ((pos = html.find(from, pos)) != std::string::npos) {
+      html.replace(pos, from.size(), to);
+      pos += to.size();
+    }
+  }
+  std::ofstream of(page, std::ios::binary | std::ios::trunc);
+  return of && of.write(html.data(), html.size()).good();
+}
+
+using State = std::map<std::string, uint64_t>;  // out_name -> input_hash
+
+State load_state(const fs::path& path) {
+  State s;
+  std::ifstream f(path);
+  std::string name;
+  uint64_t hash;
+  while (f >> name >> std::hex >> hash) s[name] = hash;
+  return s;
+}
+
+void save_state(const fs::path& path, const State& s) {
+  std::ofstream f(path, std::ios::trunc);
+  for (const auto& [name, hash] : s) {
+    f << name << " " << std::hex << hash << "\n";
+  }
+}
+
+uint64_t today_yyyymmdd() {
+  time_t t = time(nullptr);
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  return (tm.tm_year + 1900) * 10000ull + (tm.tm_mon + 1) * 100 +
+         tm.tm_mday;
+}
+
+std::string w3c_date(uint64_t ymd) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%04llu-%02llu-%02llu",
+                static_cast<unsigned long long>(ymd / 10000),
+                static_cast<unsigned long long>(ymd / 100 % 100),
+                static_cast<unsigned long long>(ymd % 100));
+  return buf;
+}
+
+std::string rfc822_date(uint64_t ymd) {
+  static const char* const kMonths[] = {"Jan", "Feb", "Mar", "Apr", "May",
+                                        "Jun", "Jul", "Aug", "Sep", "Oct",
+                                        "Nov", "Dec"};
+  unsigned mon = ymd / 100 % 100;
+  char buf[40];
+  std::snprintf(buf, sizeof(buf), "%02llu %s %04llu 00:00:00 GMT",
+                static_cast<unsigned long long>(ymd % 100),
+                kMonths[mon >= 1 && mon <= 12 ? mon - 1 : 0],
+                static_cast<unsigned long long>(ymd / 10000));
+  return buf;
+}
+
+// <title> of a built page, for feed items; the filename when absent.
+std::string page_title(const fs::path& built, const std::string& fallback) {
+  std::ifstream f(built, std::ios::binary);
+  std::ostringstream ss;
+  ss << f.rdbuf();
+  std::string html = ss.str();
+  size_t a = html.find("<title>");
+  if (a == std::string::npos) return fallback;
+  a += 7;
+  size_t b = html.find("</title>", a);
+  if (b == std::string::npos) return fallback;
+  return html.substr(a, b - a);
+}
+
+int run(const std::string& cmd) {
+  int rc = std::system(cmd.c_str());
+  if (rc != 0) std::fprintf(stderr, "sitegen: failed: %s\n", cmd.c_str());
+  return rc;
+}
+
+bool shippable_asset(const fs::path& p) {
+  std::string ext = p.extension().string();
+  return ext == ".css" || ext == ".pdf" || ext == ".ico" || ext == ".png" ||
+         ext == ".jpg" || ext == ".svg" || ext == ".webp" ||
+         p.filename() == "CNAME";
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  fs::path src_root = ".";
+  fs::path out_dir = "dist";
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "-s") && i + 1 < argc) src_root = argv[++i];
+    else if (!std::strcmp(argv[i], "-o") && i + 1 < argc) out_dir = argv[++i];
+    else {
+      std::fprintf(stderr, "usage: %s [-s source_root] [-o out_dir]\n",
+                   argv[0]);
+      return 2;
+    }
+  }
+  fs::path tools = fs::path(argv[0]).parent_path();
+  uint64_t t0 = now_ms();
+
+  // Production hotness ranking (logcat -f hot), dropped into the source
+  // root by whoever pulls the access logs.  Compression effort follows it,
+  // so its content is an input to every precompressed output: a new
+  // ranking re-runs compression at the levels it implies.
+  std::string hot_flag;
+  uint64_t hot_hash = 0;
+  if (fs::is_regular_file(src_root / ".hotness")) {
+    hot_flag = " -H " + (src_root / ".hotness").string();
+    hot_hash = fnv1a64_file(src_root / ".hotness");
+  }
+
+  // Enumerate the content tree.
+  std::vector<Node> nodes;
+  std::vector<fs::path> roots = {src_root};
+  if (fs::is_directory(src_root / "pages")) roots.push_back(src_root / "pages");
+  for (const fs::path& root : roots) {
+    for (const auto& ent : fs::directory_iterator(root)) {
+      if (!ent.is_regular_file()) continue;
+      const fs::path& p = ent.path();
+      Node n;
+      n.src = p;
+      n.out_name = p.filename().string();
+      if (p.extension() == ".html") {
+        n.is_page = true;
+        n.deps.push_back(p);
+        // Inlined stylesheets and rewritten references both make the page's
+        // output a function of the referenced asset's content.
+        for (const std::string& ref : local_refs(p)) {
+          fs::path dep = p.parent_path() / ref;
+          if (fs::is_regular_file(dep)) n.deps.push_back(dep);
+        }
+      } else if (shippable_asset(p)) {
+        n.deps.push_back(p);
+      } else {
+        continue;
+      }
+      for (const fs::path& d : n.deps) {
+        n.input_hash = n.input_hash * 0x100000001b3ull ^ fnv1a64_file(d);
+      }
+      n.content_hash = n.input_hash;
+      if (hot_hash != 0 && n.src.filename() != "CNAME") {
+        n.input_hash = n.input_hash * 0x100000001b3ull ^ hot_hash;
+      }
+      if (!n.is_page && n.src.filename() != "CNAME") {
+        n.hashed_name = hashed_name_for(n.out_name, n.input_hash);
+      }
+      nodes.push_back(std::move(n));
+    }
+  }
+
+  // Canonical name -> hashed alias, consumed by the page rewrite step.
+  std::map<std::string, std::string> aliases;
+  for (const Node& n : nodes) {
+    if (!n.hashed_name.empty()) aliases[n.out_name] = n.hashed_name;
+  }
+
+  fs::create_directories(out_dir);
+  fs::path state_path = out_dir / ".sitegen.state";
+  State prev = load_state(state_path);
+  State next;
+
+  int rebuilt = 0, reused = 0, failed = 0;
+  for (const Node& n : nodes) {
+    next[n.out_name] = n.input_hash;
+    if (!n.hashed_name.empty()) next[n.hashed_name] = n.input_hash;
+    auto it = prev.find(n.out_name);
+    if (it != prev.end() && it->second == n.input_hash &&
+        fs::exists(out_dir / n.out_name) &&
+        (n.hashed_name.empty() || fs::exists(out_dir / n.hashed_name))) {
+      reused++;
+      continue;
+    }
+    fs::path out = out_dir / n.out_name;
+    if (n.is_page) {
+      std::string o = out.string();
+      if (run((tools / "inline_assets").string() + " " + n.src.string() +
+              " " + o) != 0 ||
+          run((tools / "minify_html").string() + " " + o + " " + o) != 0 ||
+          !rewrite_refs(out, aliases) ||
+          run((tools / "precompress").string() + hot_flag + " " + o) != 0) {
+        failed++;
+        next.erase(n.out_name);  // retry next run
+        continue;
+      }
+    } else {
+      std::error_code ec;
+      fs::copy_file(n.src, out, fs::copy_options::overwrite_existing, ec);
+      if (ec) {
+        failed++;
+        next.erase(n.out_name);
+        continue;
+      }
+      if (n.src.filename() != "CNAME") {
+        run((tools / "precompress").string() + hot_flag + " " + out.string());
+      }
+      if (!n.hashed_name.empty()) {
+        // The hashed alias shares bytes with the canonical output, so the
+        // precompressed siblings can be copied rather than recompressed.
+        for (const char* ext : {"", ".gz", ".br", ".zst"}) {
+          fs::path from = out_dir / (n.out_name + ext);
+          if (!fs::exists(from)) continue;
+          std::error_code ec2;
+          fs::copy_file(from, out_dir / (n.hashed_name + ext),
+                        fs::copy_options::overwrite_existing, ec2);
+        }
+      }
+    }
+    rebuilt++;
+  }
+
+  // Gallery images get their own optimizer stage (parallel, content-hash
+  // incremental); it keeps its own state under dist/photos.
+  if (fs::is_directory(src_root / "photos")) {
+    run((tools / "imgopt").string() + " -s " + (src_root / "photos").string() +
+        " -o " + (out_dir / "photos").string());
+  }
+
+  // Sitemap and RSS feed come out of the same graph: one entry per page,
+  // lastmod pinned to the day the page's content hash last changed --
+  // carried forward in the state, so checkout and rsync mtime churn never
+  // touches it.  The pair is keyed in the state like any output and
+  // regenerates only when the page set or a page's content changed.
+  std::string domain = "localhost";
+  {
+    std::ifstream cn(src_root / "CNAME");
+    std::string d;
+    if (cn >> d && !d.empty()) domain = d;
+  }
+  uint64_t today = today_yyyymmdd();
+  uint64_t map_hash = 0;
+  for (Node& n : nodes) {
+    if (!n.is_page) continue;
+    // content_hash, not input_hash: tuning knobs like the hotness ranking
+    // must not look like edits to the page.
+    std::string key = n.out_name + "!lastmod";
+    auto lm_it = prev.find(key);
+    auto ch_it = prev.find(n.out_name + "!content");
+    uint64_t lastmod = (lm_it != prev.end() && ch_it != prev.end() &&
+                        ch_it->second == n.content_hash)
+                           ? lm_it->second
+                           : today;
+    next[key] = lastmod;
+    next[n.out_name + "!content"] = n.content_hash;
+    map_hash = map_hash * 0x100000001b3ull ^ n.content_hash ^ lastmod;
+  }
+  next["sitemap.xml"] = map_hash;
+  next["feed.xml"] = map_hash;
+  auto map_it = prev.find("sitemap.xml");
+  if (map_it == prev.end() || map_it->second != map_hash ||
+      !fs::exists(out_dir / "sitemap.xml") ||
+      !fs::exists(out_dir / "feed.xml")) {
+    std::ostringstream sm, rss;
+    sm << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+       << "<urlset xmlns=\"http://www.sitemaps.org/schemas/sitemap/0.9\">\n";
+    rss << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<rss version=\"2.0\"><channel>\n"
+        << "<title>" << domain << "</title>\n"
+        << "<link>https://" << domain << "/</link>\n"
+        << "<description>Updates from " << domain << "</description>\n";
+    for (const Node& n : nodes) {
+      if (!n.is_page) continue;
+      uint64_t lm = next[n.out_name + "!lastmod"];
+      std::string loc = "https://" + domain + "/" +
+                        (n.out_name == "index.html" ? "" : n.out_name);
+      sm << "<url><loc>" << loc << "</loc><lastmod>" << w3c_date(lm)
+         << "</lastmod></url>\n";
+      rss << "<item><title>"
+          << page_title(out_dir / n.out_name, n.out_name) << "</title>"
+          << "<link>" << loc << "</link>"
+          << "<guid isPermaLink=\"false\">" << std::hex << n.content_hash
+          << std::dec << "</guid>"
+          << "<pubDate>" << rfc822_date(lm) << "</pubDate></item>\n";
+    }
+    sm << "</urlset>\n";
+    rss << "</channel></rss>\n";
+    bool ok = true;
+    for (const auto& [name, body] :
+         {std::pair<const char*, std::string>{"sitemap.xml", sm.str()},
+          {"feed.xml", rss.str()}}) {
+      std::ofstream f(out_dir / name, std::ios::binary | std::ios::trunc);
+      if (!(f && f.write(body.data(), body.size()).good())) ok = false;
+    }
+    if (ok) {
+      run((tools / "precompress").string() + hot_flag + " " +
+          (out_dir / "sitemap.xml").string() + " " +
+          (out_dir / "feed.xml").string());
+      rebuilt++;
+    } else {
+      failed++;
+      next.erase("sitemap.xml");
+      next.erase("feed.xml");
+    }
+  } else {
+    reused++;
+  }
+
+  // Search index over page and PDF text, keyed in the state like any
+  // output: rebuilt only when an indexed document changed.
+  uint64_t idx_hash = 0;
+  for (const Node& n : nodes) {
+    if (n.is_page || n.src.extension() == ".pdf") {
+      idx_hash = idx_hash * 0x100000001b3ull ^ n.input_hash;
+    }
+  }
+  next[".searchidx"] = idx_hash;
+  auto idx_it = prev.find(".searchidx");
+  if (idx_it == prev.end() || idx_it->second != idx_hash ||
+      !fs::exists(out_dir / ".searchidx")) {
+    if (run((tools / "mkindex").string() + " -d " + out_dir.string()) != 0) {
+      failed++;
+      next.erase(".searchidx");
+    } else {
+      rebuilt++;
+    }
+  } else {
+    reused++;
+  }
+
+  // Link validation over the built pages; the same pass writes the
+  // .preload map for the server's Early Hints.  A dead internal link is a
+  // build failure.  External probing stays off here so builds are
+  // deterministic offline; "make checklinks" runs it with -e.
+  if (run((tools / "linkcheck").string() + " -d " + out_dir.string()) != 0) {
+    failed++;
+  }
+
+  // Outputs whose source vanished are removed so dist/ mirrors the tree.
+  for (const auto& [name, hash] : prev) {
+    if (next.count(name) == 0) {
+      std::error_code ec;
+      fs::remove(out_dir / name, ec);
+      for (const char* ext : {".gz", ".br", ".zst"})
+        fs::remove(out_dir / (name + ext), ec);
+    }
+  }
+
+  save_state(state_path, next);
+  std::fprintf(stderr,
+               "sitegen: %d rebuilt, %d up-to-date, %d failed in %llu ms "
+               "(%s build)\n",
+               rebuilt, reused, failed,
+               static_cast<unsigned long long>(now_ms() - t0),
+               prev.empty() ? "cold" : "warm");
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+// tplc: template compiler.  Turns an HTML page with {{name}} placeholders
+// into a generated C++ render function, so variant rendering at runtime is a
+// chain of memcpys of static literals plus variable lookups -- no parsing,
+// no allocation.  A page with no placeholders (index.html today) compiles to
+// a single segment and renders as one memcpy of the original bytes.
+//
+// The generated file defines, for a page named NAME:
+//
+//   size_t render_NAME(const TemplateVars& vars, char* out, size_t cap);
+//   extern const std::string_view kStatic_NAME;   // the no-vars bytes
+//
+// Rendering returns the byte count, or 0 if cap was too small.
+//
+//   usage: tplc <name> <input.html> <output.cc>
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Piece {
+  bool is_var;
+  std::string text;  // literal bytes, or the variable name
+};
+
+// Splits on {{ident}}.  Anything that is not a well-formed identifier
+// placeholder stays literal, so stray braces in content are harmless.
+std::vector<Piece> split(const std::string& src) {
+  std::vector<Piece> pieces;
+  std::string lit;
+  size_t pos = 0;
+  while (pos < src.size()) {
+    size_t open = src.find("{{", pos);
+    if (open == std::string::npos) {
+      lit.append(src, pos, std::string::npos);
+      break;
+    }
+    size_t close = src.find("}}", open + 2);
+    std::string name =
+        close == std::string::npos ? "" : src.substr(open + 2, close - open - 2);
+    bool ok = !name.empty();
+    for (char ch : name) {
+      if (!std::isalnum(static_cast<unsigned char>(ch)) && ch != '_')
+        ok = false;
+    }
+    if (!ok) {
+      lit.append(src, pos, open + 2 - pos);
+      pos = open + 2;
+      continue;
+    }
+    lit.append(src, pos, open - pos);
+    if (!lit.empty()) {
+      pieces.push_back({false, lit});
+      lit.clear();
+    }
+    pieces.push_back({true, name});
+    pos = close + 2;
+  }
+  if (!lit.empty()) pieces.push_back({false, lit});
+  return pieces;
+}
+
+// C string literal with everything non-printable escaped; emitted in chunks
+// so generated lines stay readable in review.
+std::string escape(const std::string& s) {
+  std::string out;
+  for (char ch : s) {
+    switch (ch) {
+      case '"': out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if (std::isprint(static_cast<unsigned char>(ch))) {
+          out += ch;
+        } else {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\x%02x",
+                        static_cast<unsigned char>(ch));
+          out += buf;
+        }
+    }
+  }
+  return out;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 4) {
+    std::fprintf(stderr, "usage: %s <name> <input.html> <output.cc>\n",
+                 argv[0]);
+    return 2;
+  }
+  const std::string name = argv[1];
+  std::ifstream in(argv[2], std::ios::binary);
+  if (!in) {
+    std::fprintf(stderr, "tplc: cannot read %s\n", argv[2]);
+    return 1;
+  }
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  const std::string src = ss.str();
+  std::vector<Piece> pieces = split(src);
+
+  std::ostringstream out;
+  out << "// Generated by tools/tplc from " << argv[2]
+      << ".  Do not edit.\n"
+      << "#include <cstring>\n\n"
+      << "#include \"srv/template.h\"\n\n"
+      << "namespace vsite::gen {\n\n";
+
+  // The no-vars bytes: with every placeholder empty this is exactly what
+  // render produces, so the fast path can serve it without running segments.
+  std::string statics;
+  for (const Piece& p : pieces) {
+    if (!p.is_var) statics += p.text;
+  }
+  // "extern" on the definition: plain "const" at namespace scope would give
+  // the symbol internal linkage and break the extern declaration above.
+  out << "extern const std::string_view kStatic_" << name << ";\n"
+      << "const std::string_view kStatic_" << name << " = \""
+      << escape(statics) << "\";\n\n";
+
+  int seg = 0;
+  for (const Piece& p : pieces) {
+    if (!p.is_var) {
+      out << "static constexpr std::string_view kSeg" << seg++ << " = \""
+          << escape(p.text) << "\";\n";
+    }
+  }
+
+  out << "\nsize_t render_" << name
+      << "(const TemplateVars& vars, char* out, size_t cap) {\n"
+      << "  if (vars.empty()) {\n"
+      << "    if (cap < kStatic_" << name << ".size()) return 0;\n"
+      << "    std::memcpy(out, kStatic_" << name << ".data(), kStatic_"
+      << name << ".size());\n"
+      << "    return kStatic_" << name << ".size();\n"
+      << "  }\n"
+      << "  size_t n = 0;\n"
+      << "  auto put = [&](std::string_view s) {\n"
+      << "    if (n + s.size() > cap) return false;\n"
+      << "    std::memcpy(out + n, s.data(), s.size());\n"
+      << "    n += s.size();\n"
+      << "    return true;\n"
+      << "  };\n";
+  seg = 0;
+  for (const Piece& p : pieces) {
+    if (p.is_var) {
+      out << "  if (!put(vars.get(\"" << p.text << "\"))) return 0;\n";
+    } else {
+      out << "  if (!put(kSeg" << seg++ << ")) return 0;\n";
+    }
+  }
+  out << "  return n;\n"
+      << "}\n\n"
+      << "}  // namespace vsite::gen\n";
+
+  std::ofstream of(argv[3], std::ios::binary | std::ios::trunc);
+  if (!of || !of.write(out.str().data(), out.str().size())) {
+    std::fprintf(stderr, "tplc: cannot write %s\n", argv[3]);
+    return 1;
+  }
+  int vars = 0;
+  for (const Piece& p : pieces)
+    if (p.is_var) vars++;
+  std::fprintf(stderr, "tplc: %s -> %s (%zu segments, %d variables)\n",
+               argv[2], argv[3], pieces.size() - vars, vars);
+  return 0;
+}